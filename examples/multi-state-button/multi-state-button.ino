@@ -18,6 +18,21 @@ HATriggers triggers(mqtt);
 Button btn(BUTTON_PIN);
 bool holdingBtn = false;
 
+void readButton(void* context) {
+    btn.read();
+
+    if (btn.pressedFor(3000) && !holdingBtn) {
+        triggers.trigger("button_long_press", BUTTON_NAME);
+        holdingBtn = true;
+    } else if (btn.wasReleased()) {
+        if (holdingBtn) {
+            holdingBtn = false;
+        } else {
+            triggers.trigger("button_short_press", BUTTON_NAME);
+        }
+    }
+}
+
 void setup() {
     // you don't need to verify return status
     Ethernet.begin(mac);
@@ -33,22 +48,13 @@ void setup() {
     triggers.add("button_long_press", BUTTON_NAME);
     btn.begin();
 
+    // the button is read every 10ms from within mqtt.loop()
+    mqtt.schedule(readButton, 0, 10);
+
     mqtt.begin(BROKER_ADDR);
 }
 
 void loop() {
     Ethernet.maintain();
     mqtt.loop();
-    btn.read();
-
-    if (btn.pressedFor(3000) && !holdingBtn) {
-        triggers.trigger("button_long_press", BUTTON_NAME);
-        holdingBtn = true;
-    } else if (btn.wasReleased()) {
-        if (holdingBtn) {
-            holdingBtn = false;
-        } else {
-            triggers.trigger("button_short_press", BUTTON_NAME);
-        }
-    }
 }
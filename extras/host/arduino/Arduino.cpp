@@ -0,0 +1,119 @@
+#include <Arduino.h>
+
+#include "../support/HostClock.h"
+
+HardwareSerial Serial;
+
+uint32_t millis()
+{
+    return (uint32_t)(HostClock::now() / 1000);
+}
+
+uint32_t micros()
+{
+    return (uint32_t)HostClock::now();
+}
+
+void delay(uint32_t ms)
+{
+    HostClock::advance(ms);
+}
+
+void yield()
+{
+
+}
+
+long random(long max)
+{
+    return (max > 0 ? rand() % max : 0);
+}
+
+long random(long min, long max)
+{
+    return (max > min ? min + random(max - min) : min);
+}
+
+void randomSeed(unsigned long seed)
+{
+    srand(seed);
+}
+
+static char* unsignedToStr(unsigned long value, char* str, int base, bool negative)
+{
+    char digits[sizeof(unsigned long) * 8 + 1];
+    uint8_t length = 0;
+
+    do {
+        const uint8_t& digit = value % base;
+        digits[length++] = (digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value > 0);
+
+    char* dst = str;
+    if (negative) {
+        *dst++ = '-';
+    }
+
+    while (length > 0) {
+        *dst++ = digits[--length];
+    }
+
+    *dst = '\0';
+    return str;
+}
+
+char* itoa(int value, char* str, int base)
+{
+    return ltoa(value, str, base);
+}
+
+char* ltoa(long value, char* str, int base)
+{
+    if (value < 0 && base == 10) {
+        return unsignedToStr(-(unsigned long)value, str, base, true);
+    }
+
+    return unsignedToStr((unsigned long)value, str, base, false);
+}
+
+char* ultoa(unsigned long value, char* str, int base)
+{
+    return unsignedToStr(value, str, base, false);
+}
+
+char* dtostrf(double value, signed char width, unsigned char precision, char* str)
+{
+    sprintf(str, "%*.*f", width, precision, value);
+    return str;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    (void)baud;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+int HardwareSerial::available()
+{
+    return 0;
+}
+
+int HardwareSerial::read()
+{
+    return -1;
+}
+
+int HardwareSerial::peek()
+{
+    return -1;
+}
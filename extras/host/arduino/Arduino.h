@@ -0,0 +1,64 @@
+#ifndef AHA_HOST_ARDUINO_H
+#define AHA_HOST_ARDUINO_H
+
+/**
+ * Minimal Arduino core that's used to build the library on a host machine.
+ * Flash memory is emulated with regular memory and the time is virtual,
+ * so it passes only when it's advanced by the harness (see HostClock).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define PGM_P const char*
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcat_P strcat
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(str) (reinterpret_cast<const __FlashStringHelper*>(str))
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+char* itoa(int value, char* str, int base);
+char* ltoa(long value, char* str, int base);
+char* ultoa(unsigned long value, char* str, int base);
+char* dtostrf(double value, signed char width, unsigned char precision, char* str);
+
+#include "Print.h"
+#include "Stream.h"
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud);
+
+    virtual size_t write(uint8_t c) override;
+    virtual size_t write(const uint8_t* buffer, size_t size) override;
+    virtual int available() override;
+    virtual int read() override;
+    virtual int peek() override;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,34 @@
+#include <Arduino.h>
+#include <IPAddress.h>
+
+IPAddress::IPAddress()
+{
+    memset(_address, 0, sizeof(_address));
+}
+
+IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+{
+    _address[0] = first;
+    _address[1] = second;
+    _address[2] = third;
+    _address[3] = fourth;
+}
+
+bool IPAddress::operator==(const IPAddress& other) const
+{
+    return (memcmp(_address, other._address, sizeof(_address)) == 0);
+}
+
+size_t IPAddress::printTo(Print& p) const
+{
+    size_t written = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i > 0) {
+            written += p.print('.');
+        }
+
+        written += p.print(_address[i], 10);
+    }
+
+    return written;
+}
@@ -0,0 +1,30 @@
+#ifndef AHA_HOST_IPADDRESS_H
+#define AHA_HOST_IPADDRESS_H
+
+#include <stdint.h>
+
+#include "Print.h"
+
+class IPAddress : public Printable
+{
+public:
+    IPAddress();
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth);
+
+    inline uint8_t operator[](int index) const
+        { return _address[index]; }
+
+    inline uint8_t& operator[](int index)
+        { return _address[index]; }
+
+    bool operator==(const IPAddress& other) const;
+
+    virtual size_t printTo(Print& p) const override;
+
+private:
+    uint8_t _address[4];
+
+    friend class Client;
+};
+
+#endif
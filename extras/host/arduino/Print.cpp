@@ -0,0 +1,118 @@
+#include <Arduino.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t written = 0;
+    while (size--) {
+        written += write(*buffer++);
+    }
+
+    return written;
+}
+
+size_t Print::print(const __FlashStringHelper* str)
+{
+    return print(reinterpret_cast<const char*>(str));
+}
+
+size_t Print::print(const char* str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(int value, int base)
+{
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base)
+{
+    if (value < 0 && base == 10) {
+        return print('-') + printNumber(-(unsigned long)value, base);
+    }
+
+    return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char str[32];
+    snprintf(str, sizeof(str), "%.*f", digits, value);
+    return print(str);
+}
+
+size_t Print::print(const Printable& value)
+{
+    return value.printTo(*this);
+}
+
+size_t Print::println()
+{
+    return write((const uint8_t*)"\r\n", 2);
+}
+
+size_t Print::println(const __FlashStringHelper* str)
+{
+    return print(str) + println();
+}
+
+size_t Print::println(const char* str)
+{
+    return print(str) + println();
+}
+
+size_t Print::println(char c)
+{
+    return print(c) + println();
+}
+
+size_t Print::println(int value, int base)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits)
+{
+    return print(value, digits) + println();
+}
+
+size_t Print::println(const Printable& value)
+{
+    return print(value) + println();
+}
+
+size_t Print::printNumber(unsigned long value, int base)
+{
+    char str[sizeof(unsigned long) * 8 + 1];
+    return print(ultoa(value, str, (base < 2 ? 10 : base)));
+}
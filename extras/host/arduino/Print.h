@@ -0,0 +1,54 @@
+#ifndef AHA_HOST_PRINT_H
+#define AHA_HOST_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class __FlashStringHelper;
+class Print;
+
+class Printable
+{
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    inline size_t write(const char* str)
+        { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const __FlashStringHelper* str);
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(int value, int base = 10);
+    size_t print(unsigned int value, int base = 10);
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(double value, int digits = 2);
+    size_t print(const Printable& value);
+
+    size_t println();
+    size_t println(const __FlashStringHelper* str);
+    size_t println(const char* str);
+    size_t println(char c);
+    size_t println(int value, int base = 10);
+    size_t println(unsigned int value, int base = 10);
+    size_t println(long value, int base = 10);
+    size_t println(unsigned long value, int base = 10);
+    size_t println(double value, int digits = 2);
+    size_t println(const Printable& value);
+
+private:
+    size_t printNumber(unsigned long value, int base);
+};
+
+#endif
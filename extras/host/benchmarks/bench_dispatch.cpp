@@ -0,0 +1,163 @@
+#include <string>
+#include <vector>
+
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostNode.h"
+
+// Cost of routing a received message through the subscriptions registry
+// (HAMqtt::processMessage) for 1-1000 subscribed switches:
+// - owned: command of each switch (the state doesn't change, so nothing is published),
+// - unknown: topic that isn't subscribed.
+// The registry is sorted by 16-bit hash and length of the topic and searched
+// with binary search, so the message is passed only to its owner (and to owners
+// of topics with colliding hash, which compare the topic) and the cost should stay flat.
+// The benchmark fails if a command doesn't reach its switch, if a message reaches
+// more than MaxReceivers switches or if the cost with 1000 switches exceeds
+// MaxGrowth times the cost with one.
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+#else
+static const char* Backend = "PubSubClient";
+#endif
+
+static const uint32_t EntitiesNb[] = {1, 10, 100, 1000};
+static const uint32_t MaxReceivers = 4;
+static const double MaxGrowth = 4;
+
+static uint32_t receptionsNb = 0;
+static uint32_t ownedReceptionsNb = 0;
+
+/**
+ * Switch that counts messages passed to it by the registry.
+ */
+class CountingSwitch : public HASwitch
+{
+public:
+    CountingSwitch(const char* name, const std::string& commandTopic, HAMqtt& mqtt) :
+        HASwitch(name, false, mqtt),
+        _commandTopic(commandTopic)
+    {
+
+    }
+
+protected:
+    virtual void onMqttMessage(
+        const char* topic,
+        const uint8_t* payload,
+        const uint16_t& length
+    ) override
+    {
+        receptionsNb++;
+        if (_commandTopic == topic) {
+            ownedReceptionsNb++;
+        }
+
+        HASwitch::onMqttMessage(topic, payload, length);
+    }
+
+private:
+    const std::string _commandTopic;
+};
+
+static bool benchDispatch(
+    HostBench& bench,
+    uint32_t entitiesNb,
+    double* ownedNsPerOp
+)
+{
+    HostNode node;
+    std::vector<std::string> topics;
+
+    for (uint32_t i = 0; i < entitiesNb; i++) {
+        const char* name = node.name("switch", i);
+        topics.push_back(std::string("homeassistant/switch/host_node/") + name + "/cmd");
+        node.add(new CountingSwitch(name, topics.back(), node.mqtt));
+    }
+
+    if (!node.connect()) {
+        printf("failed to connect with %u entities\n", entitiesNb);
+        return false;
+    }
+
+    std::string unknownTopic("homeassistant/switch/host_node/unknown/cmd");
+    uint8_t payload[] = {'O', 'F', 'F'};
+
+    // each command reaches its switch and a few switches at most
+    uint32_t totalReceptionsNb = 0;
+    uint32_t maxReceiversNb = 0;
+    ownedReceptionsNb = 0;
+
+    for (uint32_t i = 0; i < entitiesNb; i++) {
+        receptionsNb = 0;
+        node.mqtt.processMessage(&topics[i][0], payload, sizeof(payload));
+
+        totalReceptionsNb += receptionsNb;
+        if (receptionsNb > maxReceiversNb) {
+            maxReceiversNb = receptionsNb;
+        }
+    }
+
+    const uint32_t reachedNb = ownedReceptionsNb;
+
+    receptionsNb = 0;
+    node.mqtt.processMessage(&unknownTopic[0], payload, sizeof(payload));
+
+    const uint32_t unknownReceptionsNb = receptionsNb;
+
+    const uint32_t roundsNb = HostBench::roundsFor(entitiesNb, 200000);
+    const HostBench::Result owned = bench.measure("owned", entitiesNb, entitiesNb, roundsNb, [&]() {
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            node.mqtt.processMessage(&topics[i][0], payload, sizeof(payload));
+        }
+    });
+
+    bench.measure("unknown", entitiesNb, entitiesNb, roundsNb, [&]() {
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            node.mqtt.processMessage(&unknownTopic[0], payload, sizeof(payload));
+        }
+    });
+
+    *ownedNsPerOp = owned.nsPerOp;
+
+    printf(
+        "%u entities: %.3f receivers per command (max %u), %u of unknown topic\n",
+        entitiesNb,
+        (double)totalReceptionsNb / entitiesNb,
+        maxReceiversNb,
+        unknownReceptionsNb
+    );
+
+    if (reachedNb != entitiesNb || maxReceiversNb > MaxReceivers) {
+        printf("commands weren't routed through the registry\n");
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+
+    HostBench bench("Dispatch of received messages (ns per message)");
+    const size_t scalesNb = sizeof(EntitiesNb) / sizeof(EntitiesNb[0]);
+    double nsPerOp[scalesNb];
+    bool succeeded = true;
+
+    for (size_t i = 0; i < scalesNb; i++) {
+        succeeded = benchDispatch(bench, EntitiesNb[i], &nsPerOp[i]) && succeeded;
+    }
+
+    const double growth = (nsPerOp[0] > 0 ? nsPerOp[scalesNb - 1] / nsPerOp[0] : 0);
+    printf("\nowned: %u entities cost %.2fx of one entity\n", EntitiesNb[scalesNb - 1], growth);
+
+    if (growth > MaxGrowth) {
+        printf("dispatch isn't flat (max %.0fx)\n", MaxGrowth);
+        succeeded = false;
+    }
+
+    return (succeeded ? 0 : 1);
+}
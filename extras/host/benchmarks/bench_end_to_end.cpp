@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostBroker.h"
+#include "HostNode.h"
+
+// End-to-end latency of a command for 1-1000 switches: the broker routes
+// the command to the device, HAMqtt::processMessage passes it to the HASwitch,
+// the switch's callback is called and the state's echo is routed back
+// by the broker to the harness (acting as Home Assistant).
+// - latency: commands are sent one by one, p50/p99/max of the host time
+//   between publishing the command and receiving the echo,
+// - burst: a command for each switch is sent at once and the device loops
+//   until all echoes are received (messages per second of the host time).
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+#else
+static const char* Backend = "PubSubClient";
+#endif
+
+static const uint32_t EntitiesNb[] = {1, 10, 100, 1000};
+static const uint32_t SamplesNb = 5000;
+static const uint32_t WarmUpSamplesNb = 500;
+static const uint32_t BurstMessagesNb = 20000;
+static const uint32_t MaxLoopsNb = 100;
+
+static uint32_t callbacksNb = 0;
+
+static void onSwitchStateChanged(bool state, HASwitch* sender)
+{
+    (void)state;
+    (void)sender;
+
+    callbacksNb++;
+}
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p)
+{
+    const size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static bool benchEndToEnd(uint32_t entitiesNb)
+{
+    HostBroker broker;
+    HostNode node;
+    node.client.setPeer(&broker);
+
+    std::vector<HASwitch*> switches;
+    std::vector<std::string> commandTopics;
+
+    for (uint32_t i = 0; i < entitiesNb; i++) {
+        const char* name = node.name("switch", i);
+        HASwitch* entity = node.add(new HASwitch(name, false, node.mqtt));
+        entity->onStateChanged(onSwitchStateChanged);
+
+        switches.push_back(entity);
+        commandTopics.push_back(std::string("homeassistant/switch/host_node/") + name + "/cmd");
+    }
+
+    uint32_t echoesNb = 0;
+    uint64_t echoedAt = 0;
+    broker.subscribe("homeassistant/switch/host_node/+/state", [&](const HostMessage& message) {
+        (void)message;
+
+        echoedAt = HostBench::nanos();
+        echoesNb++;
+    });
+
+    if (!node.connect()) {
+        printf("failed to connect with %u entities\n", entitiesNb);
+        return false;
+    }
+
+    // sends the command that toggles the next switch
+    uint32_t next = 0;
+    auto sendCommand = [&]() {
+        HASwitch* entity = switches[next];
+        broker.publish(commandTopics[next], entity->getState() ? "OFF" : "ON");
+        next = (next + 1) % entitiesNb;
+    };
+
+    // returns false if the command wasn't echoed
+    auto sample = [&](uint64_t& latency) {
+        const uint32_t expectedEchoesNb = echoesNb + 1;
+        const uint64_t sentAt = HostBench::nanos();
+        sendCommand();
+
+        for (uint32_t i = 0; i < MaxLoopsNb && echoesNb < expectedEchoesNb; i++) {
+            node.mqtt.loop();
+        }
+
+        latency = echoedAt - sentAt;
+        return (echoesNb == expectedEchoesNb);
+    };
+
+    uint64_t latency = 0;
+    for (uint32_t i = 0; i < WarmUpSamplesNb; i++) {
+        sample(latency);
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(SamplesNb);
+    node.client.resetCounters();
+    callbacksNb = 0;
+
+    const uint64_t startedAt = HostBench::nanos();
+    for (uint32_t i = 0; i < SamplesNb; i++) {
+        if (!sample(latency)) {
+            printf("command wasn't echoed with %u entities\n", entitiesNb);
+            return false;
+        }
+
+        latencies.push_back(latency);
+    }
+
+    const double sequentialRate = SamplesNb / ((HostBench::nanos() - startedAt) / 1e9);
+    const double writesPerEcho = (double)node.client.getWriteCallsNb() / SamplesNb;
+    const bool callbacksMatch = (callbacksNb == SamplesNb);
+
+    // burst of commands, one per switch
+    const uint32_t burstsNb = std::max<uint32_t>(1, BurstMessagesNb / entitiesNb);
+    const uint64_t burstStartedAt = HostBench::nanos();
+
+    for (uint32_t burst = 0; burst < burstsNb; burst++) {
+        const uint32_t expectedEchoesNb = echoesNb + entitiesNb;
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            sendCommand();
+        }
+
+        for (uint32_t i = 0; i < MaxLoopsNb * entitiesNb && echoesNb < expectedEchoesNb; i++) {
+            node.mqtt.loop();
+        }
+
+        if (echoesNb != expectedEchoesNb) {
+            printf("burst wasn't echoed with %u entities\n", entitiesNb);
+            return false;
+        }
+    }
+
+    const double burstRate = ((double)burstsNb * entitiesNb) /
+        ((HostBench::nanos() - burstStartedAt) / 1e9);
+
+    std::sort(latencies.begin(), latencies.end());
+    printf(
+        "%8u %10llu %10llu %10llu %12.0f %12.0f %9.2f%s\n",
+        entitiesNb,
+        (unsigned long long)percentile(latencies, 0.5),
+        (unsigned long long)percentile(latencies, 0.99),
+        (unsigned long long)latencies.back(),
+        sequentialRate,
+        burstRate,
+        writesPerEcho,
+        (callbacksMatch ? "" : " (callbacks mismatch)")
+    );
+    fflush(stdout);
+
+    return callbacksMatch;
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+    printf("\nCommand -> HASwitch callback -> state echo (host time)\n");
+    printf(
+        "%8s %10s %10s %10s %12s %12s %9s\n",
+        "entities",
+        "p50 ns",
+        "p99 ns",
+        "max ns",
+        "msgs/s",
+        "burst msgs/s",
+        "writes"
+    );
+
+    bool succeeded = true;
+    for (size_t i = 0; i < sizeof(EntitiesNb) / sizeof(EntitiesNb[0]); i++) {
+        succeeded = benchEndToEnd(EntitiesNb[i]) && succeeded;
+    }
+
+    return (succeeded ? 0 : 1);
+}
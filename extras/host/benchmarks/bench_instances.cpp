@@ -0,0 +1,146 @@
+#include <deque>
+#include <memory>
+#include <stdio.h>
+
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostBroker.h"
+#include "HostNode.h"
+
+// Messages per second handled by 1-64 HAMqtt instances driven from one thread
+// and connected to the same broker:
+// - commands: a command for the switch of each instance is routed by the broker,
+//   all instances loop until the switches report the change,
+// - states: each instance publishes state of its sensor.
+// Every received command must reach the switch of its own instance,
+// the benchmark fails otherwise.
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+#else
+static const char* Backend = "PubSubClient";
+#endif
+
+static const uint32_t InstancesNb[] = {1, 2, 4, 16, 64};
+static const uint32_t MessagesNb = 50000;
+static const uint32_t MaxLoopsNb = 100;
+
+static std::vector<HASwitch*> switches;
+static std::vector<uint32_t> receivedNb;
+static HASwitch* expectedSwitch = nullptr;
+static uint32_t misroutedNb = 0;
+
+static void onSwitchStateChanged(bool state, HASwitch* sender)
+{
+    (void)state;
+
+    if (sender != expectedSwitch) {
+        misroutedNb++;
+    }
+
+    for (size_t i = 0; i < switches.size(); i++) {
+        if (switches[i] == sender) {
+            receivedNb[i]++;
+        }
+    }
+}
+
+static double rate(uint32_t messagesNb, uint64_t startedAt)
+{
+    return messagesNb / ((HostBench::nanos() - startedAt) / 1e9);
+}
+
+static bool benchInstances(uint32_t instancesNb)
+{
+    HostBroker broker;
+    std::deque<std::string> ids; // IDs must outlive the devices
+    std::vector<std::unique_ptr<HostNode>> nodes;
+    std::vector<HASensor<int32_t>*> sensors;
+    std::vector<std::string> commandTopics;
+
+    switches.clear();
+    receivedNb.assign(instancesNb, 0);
+    misroutedNb = 0;
+
+    for (uint32_t i = 0; i < instancesNb; i++) {
+        ids.push_back("node_" + std::to_string(i));
+        nodes.emplace_back(new HostNode(ids.back().c_str()));
+
+        HostNode& node = *nodes.back();
+        node.client.setPeer(&broker);
+
+        HASwitch* relay = node.add(new HASwitch("relay", false, node.mqtt));
+        relay->onStateChanged(onSwitchStateChanged);
+        switches.push_back(relay);
+        sensors.push_back(node.add(new HASensor<int32_t>("counter", 0, node.mqtt)));
+        commandTopics.push_back("homeassistant/switch/" + ids.back() + "/relay/cmd");
+
+        if (!node.connect()) {
+            printf("failed to connect %u instances\n", instancesNb);
+            return false;
+        }
+    }
+
+    // commands
+    const uint32_t roundsNb = MessagesNb / instancesNb;
+    uint64_t startedAt = HostBench::nanos();
+
+    for (uint32_t round = 0; round < roundsNb; round++) {
+        for (uint32_t i = 0; i < instancesNb; i++) {
+            const uint32_t expectedNb = receivedNb[i] + 1;
+            expectedSwitch = switches[i];
+            broker.publish(commandTopics[i], switches[i]->getState() ? "OFF" : "ON");
+
+            // all instances loop, only the addressed one may receive the command
+            for (uint32_t loop = 0; loop < MaxLoopsNb && receivedNb[i] < expectedNb; loop++) {
+                for (uint32_t j = 0; j < instancesNb; j++) {
+                    nodes[j]->mqtt.loop();
+                }
+            }
+
+            if (receivedNb[i] != expectedNb) {
+                printf("command wasn't received by instance %u of %u\n", i, instancesNb);
+                return false;
+            }
+        }
+    }
+
+    const double commandsRate = rate(roundsNb * instancesNb, startedAt);
+
+    // states
+    startedAt = HostBench::nanos();
+    for (uint32_t round = 0; round < roundsNb; round++) {
+        for (uint32_t i = 0; i < instancesNb; i++) {
+            sensors[i]->setValue(round);
+            nodes[i]->mqtt.loop();
+        }
+    }
+
+    const double statesRate = rate(roundsNb * instancesNb, startedAt);
+
+    printf(
+        "%9u %14.0f %14.0f %10u\n",
+        instancesNb,
+        commandsRate,
+        statesRate,
+        misroutedNb
+    );
+    fflush(stdout);
+
+    return (misroutedNb == 0);
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+    printf("\nMessages per second across HAMqtt instances (host time)\n");
+    printf("%9s %14s %14s %10s\n", "instances", "commands/s", "states/s", "misrouted");
+
+    bool succeeded = true;
+    for (size_t i = 0; i < sizeof(InstancesNb) / sizeof(InstancesNb[0]); i++) {
+        succeeded = benchInstances(InstancesNb[i]) && succeeded;
+    }
+
+    return (succeeded ? 0 : 1);
+}
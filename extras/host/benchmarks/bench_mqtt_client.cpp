@@ -0,0 +1,89 @@
+#include <stdio.h>
+
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostHeap.h"
+#include "HostNode.h"
+
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+#include <PubSubClient.h>
+#endif
+
+// RAM and throughput of the MQTT backend (PubSubClient or the built-in client
+// enabled with ARDUINOHA_NATIVE_MQTT). Each backend is a separate executable,
+// code size of both is reported by the size_mqtt_client* tests.
+// - RAM: HAMqtt with the embedded client, the client's heap and the library's heap
+//   of a connected device with a sensor and a switch,
+// - throughput: states with QoS 0 and 1 and received commands (QoS 1 only
+//   if ARDUINOHA_INFLIGHT_SIZE is enabled, the RAM is reported for the defaults).
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+static const size_t ClientHeapBytes = 0;
+#else
+static const char* Backend = "PubSubClient";
+static const size_t ClientHeapBytes = MQTT_MAX_PACKET_SIZE; // allocated by PubSubClient
+#endif
+
+static void printRate(const HostBench::Result& result)
+{
+    printf("%-22s %12.0f msgs/s\n", result.path, (result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0));
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+
+    HostNode node;
+    HASensor<int32_t>* sensor = node.add(new HASensor<int32_t>("temperature", 0, node.mqtt));
+    HASwitch* relay = node.add(new HASwitch("relay", false, node.mqtt));
+
+    if (!node.connect()) {
+        printf("failed to connect\n");
+        return 1;
+    }
+
+    const size_t mqttBytes = sizeof(HAMqtt);
+    const size_t libraryHeapBytes = HostHeap::getLiveBytes();
+
+    printf("\nRAM of a connected device (sensor and switch)\n");
+    printf("%-32s %6zu B\n", "sizeof(HAMqtt) with the client", mqttBytes);
+    printf("%-32s %6zu B\n", "client's heap", ClientHeapBytes);
+    printf("%-32s %6zu B\n", "library's heap", libraryHeapBytes);
+    printf("%-32s %6zu B\n", "total", mqttBytes + ClientHeapBytes + libraryHeapBytes);
+
+    HostBench bench("Throughput", &node.client);
+    int32_t value = 0;
+
+    const HostBench::Result qos0 = bench.measure("state_qos0", 1, 1, 20000, [&]() {
+        sensor->setValue(++value);
+    });
+
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    node.mqtt.setPublishQoS(1);
+    const HostBench::Result qos1 = bench.measure("state_qos1", 1, 1, 20000, [&]() {
+        sensor->setValue(++value);
+        node.mqtt.loop(); // PUBACK
+    });
+
+    node.mqtt.setPublishQoS(0);
+#endif
+
+    const HostBench::Result command = bench.measure("command", 1, 1, 20000, [&]() {
+        node.responder.publish(
+            "homeassistant/switch/host_node/relay/cmd",
+            relay->getState() ? "OFF" : "ON"
+        );
+        node.pump();
+    });
+
+    printf("\n");
+    printRate(qos0);
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    printRate(qos1);
+#endif
+    printRate(command);
+
+    return 0;
+}
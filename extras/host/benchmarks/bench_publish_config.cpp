@@ -0,0 +1,202 @@
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostNode.h"
+#include "HostStack.h"
+
+// Cost of a full publishConfig of each device type and of the PROGMEM
+// fragments its payload is made of:
+// - writePayload_P: the library's path, flash data is streamed through
+//   a fixed buffer of HAMqtt::ProgmemChunkSize bytes,
+// - legacy: the previous implementation, the whole fragment is copied
+//   to a stack VLA with strcpy_P and written after another strlen.
+// The legacy path is reimplemented here on top of the public API.
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+#else
+static const char* Backend = "PubSubClient";
+#endif
+
+#define AHA_BENCH_DECORATOR_32 ",\"json_attr_t\":\"aha/attributes\""
+#define AHA_BENCH_DECORATOR_256 \
+    AHA_BENCH_DECORATOR_32 AHA_BENCH_DECORATOR_32 AHA_BENCH_DECORATOR_32 AHA_BENCH_DECORATOR_32 \
+    AHA_BENCH_DECORATOR_32 AHA_BENCH_DECORATOR_32 AHA_BENCH_DECORATOR_32 AHA_BENCH_DECORATOR_32
+
+// fragments of HASensor's config payload
+static const char Opening[] PROGMEM = {"{"};
+static const char StateTopic[] PROGMEM = {"\"stat_t\":\""};
+static const char DeviceClass[] PROGMEM = {",\"dev_cla\":\""};
+static const char Unit[] PROGMEM = {",\"unit_of_meas\":\""};
+static const char Name[] PROGMEM = {",\"name\":\""};
+static const char UniqueId[] PROGMEM = {",\"uniq_id\":\""};
+static const char AvailabilityTopic[] PROGMEM = {",\"avty_t\":\""};
+static const char Device[] PROGMEM = {",\"dev\":"};
+static const char Closing[] PROGMEM = {"}"};
+static const char* const SensorFragments[] = {
+    Opening,
+    StateTopic,
+    DeviceClass,
+    Unit,
+    Name,
+    UniqueId,
+    AvailabilityTopic,
+    Device,
+    Closing
+};
+
+// a long decorator shows how the stack of the legacy path grows
+static const char LongDecorator[] PROGMEM = {AHA_BENCH_DECORATOR_256};
+static const char* const LongFragments[] = {LongDecorator};
+
+static bool legacyWritePayload_P(HAMqtt& mqtt, const char* src)
+{
+    char data[strlen_P(src) + 1];
+    strcpy_P(data, src);
+
+    return mqtt.writePayload(data, strlen(data));
+}
+
+static void writeFragments(
+    HAMqtt& mqtt,
+    const char* const* fragments,
+    uint32_t fragmentsNb,
+    bool legacy
+)
+{
+    for (uint32_t i = 0; i < fragmentsNb; i++) {
+        if (legacy) {
+            legacyWritePayload_P(mqtt, fragments[i]);
+        } else {
+            mqtt.writePayload_P(fragments[i]);
+        }
+    }
+}
+
+/**
+ * Measures the fragments and returns stack used by their writes alone
+ * (the round's stack is dominated by beginPublish and endPublish).
+ */
+static size_t benchFragments(
+    HostBench& bench,
+    const char* path,
+    const char* const* fragments,
+    uint32_t fragmentsNb,
+    bool legacy
+)
+{
+    HostNode node;
+    if (!node.connect()) {
+        printf("failed to connect\n");
+        return 0;
+    }
+
+    uint16_t payloadLength = 0;
+    for (uint32_t i = 0; i < fragmentsNb; i++) {
+        payloadLength += strlen_P(fragments[i]);
+    }
+
+    bench.setClient(&node.client);
+    bench.measure(path, 1, fragmentsNb, 20000, [&]() {
+        node.mqtt.beginPublish("aha/bench/config", payloadLength);
+        writeFragments(node.mqtt, fragments, fragmentsNb, legacy);
+        node.mqtt.endPublish();
+    });
+
+    bench.setClient(nullptr);
+
+    node.mqtt.beginPublish("aha/bench/config", payloadLength);
+    HostStack::paint();
+    writeFragments(node.mqtt, fragments, fragmentsNb, legacy);
+    const size_t stackBytes = HostStack::used();
+    node.mqtt.endPublish();
+
+    return stackBytes;
+}
+
+template <typename T>
+static void benchConfig(HostBench& bench, const char* path, T* (*create)(HAMqtt& mqtt))
+{
+    HostNode node("0123456789ab");
+    node.device.setName("Host node");
+    node.device.setManufacturer("ArduinoHA");
+    node.device.setModel("host");
+    node.device.setSoftwareVersion("1.0.0");
+    node.add(create(node.mqtt));
+
+    if (!node.connect()) {
+        printf("failed to connect\n");
+        return;
+    }
+
+    bench.setClient(&node.client);
+    bench.measure(path, 1, 1, 20000, [&]() {
+        node.mqtt.forceDiscovery();
+
+        while (!node.mqtt.isDiscoveryCompleted()) {
+            node.mqtt.loop();
+        }
+    });
+
+    bench.setClient(nullptr);
+}
+
+static HASensor<float>* createSensor(HAMqtt& mqtt)
+{
+    HASensor<float>* sensor = new HASensor<float>("temperature", "temperature", 0, mqtt);
+    sensor->setUnitOfMeasurement("C");
+    return sensor;
+}
+
+static HABinarySensor* createBinarySensor(HAMqtt& mqtt)
+{
+    return new HABinarySensor("door", "door", false, mqtt);
+}
+
+static HASwitch* createSwitch(HAMqtt& mqtt)
+{
+    return new HASwitch("relay", false, mqtt);
+}
+
+static HATriggers* createTriggers(HAMqtt& mqtt)
+{
+    HATriggers* triggers = new HATriggers(mqtt);
+    triggers->add("button_short_press", "button_1");
+    triggers->add("button_long_press", "button_1");
+    return triggers;
+}
+
+static HATagScanner* createTagScanner(HAMqtt& mqtt)
+{
+    return new HATagScanner("reader", mqtt);
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+
+    HostBench configs("Full publishConfig (one device type)");
+    benchConfig(configs, "sensor", createSensor);
+    benchConfig(configs, "binary_sensor", createBinarySensor);
+    benchConfig(configs, "switch", createSwitch);
+    benchConfig(configs, "triggers (2)", createTriggers);
+    benchConfig(configs, "tag_scanner", createTagScanner);
+
+    const uint32_t sensorFragmentsNb = sizeof(SensorFragments) / sizeof(SensorFragments[0]);
+    HostBench fragments("PROGMEM fragments (ns and writes per fragment)");
+    const size_t stackBytes[] = {
+        benchFragments(fragments, "writePayload_P", SensorFragments, sensorFragmentsNb, false),
+        benchFragments(fragments, "legacy", SensorFragments, sensorFragmentsNb, true),
+        benchFragments(fragments, "writePayload_P 256 B", LongFragments, 1, false),
+        benchFragments(fragments, "legacy 256 B", LongFragments, 1, true)
+    };
+
+    printf("\nStack of the fragments' writes\n");
+    printf("%-22s %9s\n", "path", "stack B");
+    printf("%-22s %9zu\n", "writePayload_P", stackBytes[0]);
+    printf("%-22s %9zu\n", "legacy", stackBytes[1]);
+    printf("%-22s %9zu\n", "writePayload_P 256 B", stackBytes[2]);
+    printf("%-22s %9zu\n", "legacy 256 B", stackBytes[3]);
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostNode.h"
+
+// Cost of each publish path of the library for 1-1000 entities:
+// - discovery: config of each entity (publishConfig) after forceDiscovery,
+// - state_qos0: HASensor::setValue of each entity,
+// - state_qos1: the same with QoS 1, including processing of PUBACK in the loop,
+// - deferred: setValue of each entity and a single HAMqtt::flush
+//   (entities above ARDUINOHA_DIRTY_SET_SIZE are published right away),
+// - trigger: HATriggers::trigger of each entity.
+// Serializers used by all paths are measured separately.
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+#else
+static const char* Backend = "PubSubClient";
+#endif
+
+static const uint32_t EntitiesNb[] = {1, 10, 100, 1000};
+
+static void addSensors(HostNode& node, std::vector<HASensor<int32_t>*>& sensors, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        sensors.push_back(node.add(new HASensor<int32_t>(node.name("sensor", i), 0, node.mqtt)));
+    }
+}
+
+static void benchSensors(HostBench& bench, uint32_t entitiesNb)
+{
+    HostNode node;
+    std::vector<HASensor<int32_t>*> sensors;
+    addSensors(node, sensors, entitiesNb);
+
+    if (!node.connect()) {
+        printf("failed to connect with %u entities\n", entitiesNb);
+        return;
+    }
+
+    bench.setClient(&node.client);
+    const uint32_t roundsNb = HostBench::roundsFor(entitiesNb);
+    int32_t value = 0;
+
+    bench.measure("discovery", entitiesNb, entitiesNb, HostBench::roundsFor(entitiesNb, 2000), [&]() {
+        node.mqtt.forceDiscovery();
+
+        while (!node.mqtt.isDiscoveryCompleted()) {
+            node.mqtt.loop();
+        }
+    });
+
+    bench.measure("state_qos0", entitiesNb, entitiesNb, roundsNb, [&]() {
+        value++;
+
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            sensors[i]->setValue(value);
+        }
+    });
+
+    node.mqtt.setPublishQoS(1);
+    bench.measure("state_qos1", entitiesNb, entitiesNb, roundsNb, [&]() {
+        value++;
+
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            sensors[i]->setValue(value);
+            node.mqtt.loop(); // PUBACK
+        }
+    });
+
+    node.mqtt.setPublishQoS(0);
+    node.mqtt.setDeferredPublishing(true);
+    bench.measure("deferred", entitiesNb, entitiesNb, roundsNb, [&]() {
+        value++;
+
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            sensors[i]->setValue(value);
+        }
+
+        node.mqtt.flush();
+    });
+
+    bench.setClient(nullptr);
+}
+
+static void benchTriggers(HostBench& bench, uint32_t entitiesNb)
+{
+    HostNode node;
+    std::vector<HATriggers*> triggers;
+    std::vector<const char*> subtypes;
+
+    for (uint32_t i = 0; i < entitiesNb; i++) {
+        HATriggers* entity = node.add(new HATriggers(node.mqtt));
+        subtypes.push_back(node.name("button", i));
+        entity->add("button_short_press", subtypes[i]);
+        triggers.push_back(entity);
+    }
+
+    if (!node.connect()) {
+        printf("failed to connect with %u entities\n", entitiesNb);
+        return;
+    }
+
+    bench.setClient(&node.client);
+    bench.measure("trigger", entitiesNb, entitiesNb, HostBench::roundsFor(entitiesNb), [&]() {
+        for (uint32_t i = 0; i < entitiesNb; i++) {
+            triggers[i]->trigger("button_short_press", subtypes[i]);
+        }
+    });
+
+    bench.setClient(nullptr);
+}
+
+static void benchSerializers(HostBench& bench)
+{
+    HostNode node("0123456789ab");
+    HADevice& device = node.device;
+    device.setName("Host node");
+    device.setManufacturer("ArduinoHA");
+    device.setModel("host");
+    device.setSoftwareVersion("1.0.0");
+
+    const HAMqtt* mqtt = &node.mqtt;
+    const uint16_t& topicLength = DeviceTypeSerializer::calculateTopicLength(
+        mqtt,
+        "sensor",
+        "temperature",
+        DeviceTypeSerializer::StateTopic
+    );
+    char topic[topicLength];
+
+    bench.measure("generateTopic", 1, 1, 100000, [&]() {
+        DeviceTypeSerializer::generateTopic(
+            mqtt,
+            topic,
+            "sensor",
+            "temperature",
+            DeviceTypeSerializer::StateTopic
+        );
+    });
+
+    char serializedDevice[device.calculateSerializedLength()];
+    bench.measure("HADevice::serialize", 1, 1, 100000, [&]() {
+        device.serialize(serializedDevice);
+    });
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+
+    HostBench bench("Publish paths");
+    for (size_t i = 0; i < sizeof(EntitiesNb) / sizeof(EntitiesNb[0]); i++) {
+        benchSensors(bench, EntitiesNb[i]);
+        benchTriggers(bench, EntitiesNb[i]);
+    }
+
+    HostBench serializers("Serializers");
+    benchSerializers(serializers);
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <ArduinoHA.h>
+
+#include "HostBench.h"
+#include "HostNode.h"
+
+// Write calls of the network client per MQTT message. The benchmark is built
+// with different values of ARDUINOHA_WRITE_BUFFER_SIZE (0 disables combining
+// of the writes, i.e. the behavior before the buffer was added), so each
+// executable reports a single configuration:
+// - <type> config: messages published by the device type's discovery,
+// - state_qos0 / state_qos1: HASensor::setValue.
+// With the buffer enabled, each message may take at most one write
+// per ARDUINOHA_WRITE_BUFFER_SIZE bytes (plus one for the rest), the benchmark fails otherwise.
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+static const char* Backend = "built-in MQTT client";
+#else
+static const char* Backend = "PubSubClient";
+#endif
+
+static bool succeeded = true;
+
+static void verify(const HostBench::Result& result)
+{
+#if ARDUINOHA_WRITE_BUFFER_SIZE > 0
+    const double maxWritesPerOp = result.bytesPerOp / ARDUINOHA_WRITE_BUFFER_SIZE + 1;
+    if (result.writesPerOp > maxWritesPerOp) {
+        printf("%s: too many writes per message (max %.2f)\n", result.path, maxWritesPerOp);
+        succeeded = false;
+    }
+#else
+    (void)result;
+#endif
+}
+
+template <typename T>
+static void benchConfig(HostBench& bench, const char* path, T* deviceType, HostNode& node)
+{
+    node.add(deviceType);
+    if (!node.connect()) {
+        printf("failed to connect\n");
+        succeeded = false;
+        return;
+    }
+
+    // number of messages published by a single discovery
+    auto round = [&]() {
+        node.mqtt.forceDiscovery();
+
+        while (!node.mqtt.isDiscoveryCompleted()) {
+            node.mqtt.loop();
+        }
+    };
+
+    const uint32_t publishesNb = node.responder.getPublishesNb();
+    round();
+    const uint32_t messagesNb = node.responder.getPublishesNb() - publishesNb;
+
+    bench.setClient(&node.client);
+    verify(bench.measure(path, 1, messagesNb, HostBench::roundsFor(messagesNb), round));
+    bench.setClient(nullptr);
+}
+
+static void benchStates(HostBench& bench)
+{
+    HostNode node;
+    HASensor<float>* sensor = node.add(new HASensor<float>("temperature", 0, node.mqtt));
+    if (!node.connect()) {
+        printf("failed to connect\n");
+        succeeded = false;
+        return;
+    }
+
+    float value = 0;
+    bench.setClient(&node.client);
+    verify(bench.measure("state_qos0", 1, 1, 10000, [&]() {
+        value += 0.5f;
+        sensor->setValue(value);
+    }));
+
+    node.mqtt.setPublishQoS(1);
+    verify(bench.measure("state_qos1", 1, 1, 10000, [&]() {
+        value += 0.5f;
+        sensor->setValue(value);
+        node.mqtt.loop(); // PUBACK
+    }));
+
+    bench.setClient(nullptr);
+}
+
+int main()
+{
+    printf("Backend: %s\n", Backend);
+    printf("ARDUINOHA_WRITE_BUFFER_SIZE: %u\n", (unsigned)ARDUINOHA_WRITE_BUFFER_SIZE);
+
+    HostBench bench("Writes per message");
+
+    {
+        HostNode node("0123456789ab");
+        benchConfig(bench, "sensor config", new HASensor<float>("temperature", "temperature", 0, node.mqtt), node);
+    }
+
+    {
+        HostNode node("0123456789ab");
+        benchConfig(bench, "binary_sensor config", new HABinarySensor("door", "door", false, node.mqtt), node);
+    }
+
+    {
+        HostNode node("0123456789ab");
+        benchConfig(bench, "switch config", new HASwitch("relay", false, node.mqtt), node);
+    }
+
+    {
+        HostNode node("0123456789ab");
+        HATriggers* triggers = new HATriggers(node.mqtt);
+        triggers->add("button_short_press", "button_1");
+        triggers->add("button_long_press", "button_1");
+        benchConfig(bench, "triggers config", triggers, node);
+    }
+
+    benchStates(bench);
+
+    return (succeeded ? 0 : 1);
+}
@@ -0,0 +1,607 @@
+#include "PubSubClient.h"
+
+PubSubClient::PubSubClient() :
+    _client(nullptr),
+    _buffer(nullptr),
+    _bufferSize(0),
+    _keepAlive(MQTT_KEEPALIVE),
+    _socketTimeout(MQTT_SOCKET_TIMEOUT),
+    _nextMsgId(1),
+    _lastOutActivity(0),
+    _lastInActivity(0),
+    _pingOutstanding(false),
+    callback(nullptr),
+    _domain(nullptr),
+    _port(0),
+    _state(MQTT_DISCONNECTED)
+{
+    // PubSubClient 2.8 allocates its packet buffer in the constructor
+    setBufferSize(MQTT_MAX_PACKET_SIZE);
+}
+
+PubSubClient::PubSubClient(Client& client) :
+    PubSubClient()
+{
+    setClient(client);
+}
+
+PubSubClient::~PubSubClient()
+{
+    free(_buffer);
+}
+
+PubSubClient& PubSubClient::setServer(IPAddress ip, uint16_t port)
+{
+    _ip = ip;
+    _port = port;
+    _domain = nullptr;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setServer(const char* domain, uint16_t port)
+{
+    _domain = domain;
+    _port = port;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
+{
+    this->callback = callback;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setClient(Client& client)
+{
+    _client = &client;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setKeepAlive(uint16_t keepAlive)
+{
+    _keepAlive = keepAlive;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setSocketTimeout(uint16_t timeout)
+{
+    _socketTimeout = timeout;
+    return *this;
+}
+
+boolean PubSubClient::setBufferSize(uint16_t size)
+{
+    if (size == 0) {
+        return false;
+    }
+
+    uint8_t* buffer = (uint8_t*)realloc(_buffer, size);
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    _buffer = buffer;
+    _bufferSize = size;
+    return true;
+}
+
+uint16_t PubSubClient::getBufferSize()
+{
+    return _bufferSize;
+}
+
+boolean PubSubClient::connect(const char* id)
+{
+    return connect(id, nullptr, nullptr, nullptr, 0, false, nullptr, true);
+}
+
+boolean PubSubClient::connect(const char* id, const char* user, const char* pass)
+{
+    return connect(id, user, pass, nullptr, 0, false, nullptr, true);
+}
+
+boolean PubSubClient::connect(
+    const char* id,
+    const char* willTopic,
+    uint8_t willQos,
+    boolean willRetain,
+    const char* willMessage
+)
+{
+    return connect(id, nullptr, nullptr, willTopic, willQos, willRetain, willMessage, true);
+}
+
+boolean PubSubClient::connect(
+    const char* id,
+    const char* user,
+    const char* pass,
+    const char* willTopic,
+    uint8_t willQos,
+    boolean willRetain,
+    const char* willMessage
+)
+{
+    return connect(id, user, pass, willTopic, willQos, willRetain, willMessage, true);
+}
+
+boolean PubSubClient::connect(
+    const char* id,
+    const char* user,
+    const char* pass,
+    const char* willTopic,
+    uint8_t willQos,
+    boolean willRetain,
+    const char* willMessage,
+    boolean cleanSession
+)
+{
+    if (connected()) {
+        return true;
+    }
+
+    int result = 1;
+    if (!_client->connected()) {
+        result = (_domain != nullptr ?
+            _client->connect(_domain, _port) :
+            _client->connect(_ip, _port));
+    }
+
+    if (result != 1) {
+        _state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    _nextMsgId = 1;
+
+    uint16_t length = MQTT_MAX_HEADER_SIZE;
+    const uint8_t protocol[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', MQTT_VERSION};
+    memcpy(_buffer + length, protocol, sizeof(protocol));
+    length += sizeof(protocol);
+
+    uint8_t flags = 0;
+    if (willTopic != nullptr) {
+        flags = 0x04 | (willQos << 3) | (willRetain << 5);
+    }
+
+    if (cleanSession) {
+        flags |= 0x02;
+    }
+
+    if (user != nullptr) {
+        flags |= 0x80;
+
+        if (pass != nullptr) {
+            flags |= 0x40;
+        }
+    }
+
+    _buffer[length++] = flags;
+    _buffer[length++] = (_keepAlive >> 8);
+    _buffer[length++] = (_keepAlive & 0xFF);
+
+    length = writeString(id, _buffer, length);
+    if (willTopic != nullptr) {
+        length = writeString(willTopic, _buffer, length);
+        length = writeString(willMessage, _buffer, length);
+    }
+
+    if (user != nullptr) {
+        length = writeString(user, _buffer, length);
+
+        if (pass != nullptr) {
+            length = writeString(pass, _buffer, length);
+        }
+    }
+
+    if (length > _bufferSize) {
+        _state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    write(MQTTCONNECT, _buffer, length - MQTT_MAX_HEADER_SIZE);
+    _lastInActivity = _lastOutActivity = millis();
+
+    while (!_client->available()) {
+        if (millis() - _lastInActivity >= _socketTimeout * 1000UL) {
+            _state = MQTT_CONNECTION_TIMEOUT;
+            _client->stop();
+            return false;
+        }
+
+        delay(1);
+    }
+
+    uint8_t lengthLength;
+    if (readPacket(&lengthLength) == 4) {
+        if (_buffer[3] == 0) {
+            _lastInActivity = millis();
+            _pingOutstanding = false;
+            _state = MQTT_CONNECTED;
+            return true;
+        }
+
+        _state = _buffer[3];
+    }
+
+    _client->stop();
+    return false;
+}
+
+void PubSubClient::disconnect()
+{
+    _buffer[0] = MQTTDISCONNECT;
+    _buffer[1] = 0;
+    _client->write(_buffer, 2);
+    _state = MQTT_DISCONNECTED;
+    _client->flush();
+    _client->stop();
+    _lastInActivity = _lastOutActivity = millis();
+}
+
+boolean PubSubClient::publish(const char* topic, const char* payload)
+{
+    return publish(topic, (const uint8_t*)payload, (payload ? strlen(payload) : 0), false);
+}
+
+boolean PubSubClient::publish(const char* topic, const char* payload, boolean retained)
+{
+    return publish(topic, (const uint8_t*)payload, (payload ? strlen(payload) : 0), retained);
+}
+
+boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length)
+{
+    return publish(topic, payload, length, false);
+}
+
+boolean PubSubClient::publish(
+    const char* topic,
+    const uint8_t* payload,
+    unsigned int length,
+    boolean retained
+)
+{
+    if (!connected()) {
+        return false;
+    }
+
+    if (MQTT_MAX_HEADER_SIZE + 2 + strlen(topic) + length > _bufferSize) {
+        return false;
+    }
+
+    uint16_t pos = writeString(topic, _buffer, MQTT_MAX_HEADER_SIZE);
+    memcpy(_buffer + pos, payload, length);
+    pos += length;
+
+    return write(MQTTPUBLISH | (retained ? 1 : 0), _buffer, pos - MQTT_MAX_HEADER_SIZE);
+}
+
+boolean PubSubClient::beginPublish(const char* topic, unsigned int length, boolean retained)
+{
+    if (!connected()) {
+        return false;
+    }
+
+    // the topic is sent with the header and the payload is written directly
+    const uint16_t& topicLength = writeString(topic, _buffer, MQTT_MAX_HEADER_SIZE);
+    const size_t& headerLength = buildHeader(
+        MQTTPUBLISH | (retained ? 1 : 0),
+        _buffer,
+        length + topicLength - MQTT_MAX_HEADER_SIZE
+    );
+    const size_t& offset = MQTT_MAX_HEADER_SIZE - headerLength;
+    const size_t& packetLength = topicLength - offset;
+
+    _lastOutActivity = millis();
+    return (_client->write(_buffer + offset, packetLength) == packetLength);
+}
+
+int PubSubClient::endPublish()
+{
+    return 1;
+}
+
+size_t PubSubClient::write(uint8_t c)
+{
+    _lastOutActivity = millis();
+    return _client->write(c);
+}
+
+size_t PubSubClient::write(const uint8_t* buffer, size_t size)
+{
+    _lastOutActivity = millis();
+    return _client->write(buffer, size);
+}
+
+boolean PubSubClient::subscribe(const char* topic)
+{
+    return subscribe(topic, 0);
+}
+
+boolean PubSubClient::subscribe(const char* topic, uint8_t qos)
+{
+    if (qos > 1 || !connected()) {
+        return false;
+    }
+
+    const size_t& topicLength = strlen(topic);
+    if (MQTT_MAX_HEADER_SIZE + 2 + 2 + topicLength + 1 > _bufferSize) {
+        return false;
+    }
+
+    uint16_t length = MQTT_MAX_HEADER_SIZE;
+    const uint16_t& packetId = nextPacketId();
+    _buffer[length++] = (packetId >> 8);
+    _buffer[length++] = (packetId & 0xFF);
+    length = writeString(topic, _buffer, length);
+    _buffer[length++] = qos;
+
+    return write(MQTTSUBSCRIBE | MQTTQOS1, _buffer, length - MQTT_MAX_HEADER_SIZE);
+}
+
+boolean PubSubClient::unsubscribe(const char* topic)
+{
+    if (!connected()) {
+        return false;
+    }
+
+    const size_t& topicLength = strlen(topic);
+    if (MQTT_MAX_HEADER_SIZE + 2 + 2 + topicLength > _bufferSize) {
+        return false;
+    }
+
+    uint16_t length = MQTT_MAX_HEADER_SIZE;
+    const uint16_t& packetId = nextPacketId();
+    _buffer[length++] = (packetId >> 8);
+    _buffer[length++] = (packetId & 0xFF);
+    length = writeString(topic, _buffer, length);
+
+    return write(MQTTUNSUBSCRIBE | MQTTQOS1, _buffer, length - MQTT_MAX_HEADER_SIZE);
+}
+
+boolean PubSubClient::loop()
+{
+    if (!connected()) {
+        return false;
+    }
+
+    const uint32_t& now = millis();
+    if (now - _lastInActivity > _keepAlive * 1000UL ||
+            now - _lastOutActivity > _keepAlive * 1000UL) {
+        if (_pingOutstanding) {
+            _state = MQTT_CONNECTION_TIMEOUT;
+            _client->stop();
+            return false;
+        }
+
+        _buffer[0] = MQTTPINGREQ;
+        _buffer[1] = 0;
+        _client->write(_buffer, 2);
+        _lastOutActivity = now;
+        _lastInActivity = now;
+        _pingOutstanding = true;
+    }
+
+    if (!_client->available()) {
+        return true;
+    }
+
+    uint8_t lengthLength;
+    const uint32_t& length = readPacket(&lengthLength);
+    if (length == 0) {
+        // readPacket may have closed the connection
+        return connected();
+    }
+
+    _lastInActivity = now;
+    const uint8_t& type = (_buffer[0] & 0xF0);
+
+    if (type == MQTTPUBLISH) {
+        if (callback == nullptr) {
+            return true;
+        }
+
+        const uint16_t& topicLength = (_buffer[lengthLength + 1] << 8) + _buffer[lengthLength + 2];
+        memmove(_buffer + lengthLength + 2, _buffer + lengthLength + 3, topicLength);
+        _buffer[lengthLength + 2 + topicLength] = 0;
+        char* topic = (char*)_buffer + lengthLength + 2;
+
+        if ((_buffer[0] & 0x06) == MQTTQOS1) {
+            const uint16_t& msgId =
+                (_buffer[lengthLength + 3 + topicLength] << 8) +
+                _buffer[lengthLength + 3 + topicLength + 1];
+            uint8_t* payload = _buffer + lengthLength + 3 + topicLength + 2;
+            callback(topic, payload, length - lengthLength - 3 - topicLength - 2);
+
+            _buffer[0] = MQTTPUBACK;
+            _buffer[1] = 2;
+            _buffer[2] = (msgId >> 8);
+            _buffer[3] = (msgId & 0xFF);
+            _client->write(_buffer, 4);
+            _lastOutActivity = now;
+        } else {
+            uint8_t* payload = _buffer + lengthLength + 3 + topicLength;
+            callback(topic, payload, length - lengthLength - 3 - topicLength);
+        }
+    } else if (type == MQTTPINGREQ) {
+        _buffer[0] = MQTTPINGRESP;
+        _buffer[1] = 0;
+        _client->write(_buffer, 2);
+    } else if (type == MQTTPINGRESP) {
+        _pingOutstanding = false;
+    }
+
+    return true;
+}
+
+boolean PubSubClient::connected()
+{
+    if (_client == nullptr) {
+        return false;
+    }
+
+    if (!_client->connected()) {
+        if (_state == MQTT_CONNECTED) {
+            _state = MQTT_CONNECTION_LOST;
+            _client->flush();
+            _client->stop();
+        }
+
+        return false;
+    }
+
+    return (_state == MQTT_CONNECTED);
+}
+
+int PubSubClient::state()
+{
+    return _state;
+}
+
+uint32_t PubSubClient::readPacket(uint8_t* lengthLength)
+{
+    uint16_t length = 0;
+    if (!readByte(_buffer, &length)) {
+        return 0;
+    }
+
+    const bool& isPublish = ((_buffer[0] & 0xF0) == MQTTPUBLISH);
+    uint32_t multiplier = 1;
+    uint32_t remainingLength = 0;
+    uint8_t digit = 0;
+
+    do {
+        if (length == 5) {
+            // invalid encoding of the remaining length
+            _state = MQTT_DISCONNECTED;
+            _client->stop();
+            return 0;
+        }
+
+        if (!readByte(&digit)) {
+            return 0;
+        }
+
+        _buffer[length++] = digit;
+        remainingLength += (digit & 127) * multiplier;
+        multiplier <<= 7;
+    } while ((digit & 128) != 0);
+
+    *lengthLength = length - 1;
+
+    uint32_t start = 0;
+    if (isPublish) {
+        if (!readByte(_buffer, &length) || !readByte(_buffer, &length)) {
+            return 0;
+        }
+
+        start = 2;
+    }
+
+    uint32_t index = length;
+    for (uint32_t i = start; i < remainingLength; i++) {
+        if (!readByte(&digit)) {
+            return 0;
+        }
+
+        if (length < _bufferSize) {
+            _buffer[length++] = digit;
+        }
+
+        index++;
+    }
+
+    if (index > _bufferSize) {
+        // packets that don't fit the buffer are ignored
+        return 0;
+    }
+
+    return length;
+}
+
+boolean PubSubClient::readByte(uint8_t* result)
+{
+    const uint32_t& startedAt = millis();
+
+    while (!_client->available()) {
+        if (millis() - startedAt >= _socketTimeout * 1000UL) {
+            return false;
+        }
+
+        delay(1);
+    }
+
+    *result = _client->read();
+    return true;
+}
+
+boolean PubSubClient::readByte(uint8_t* result, uint16_t* index)
+{
+    uint8_t* current = result + *index;
+    if (!readByte(current)) {
+        return false;
+    }
+
+    (*index)++;
+    return true;
+}
+
+boolean PubSubClient::write(uint8_t header, uint8_t* buffer, uint16_t length)
+{
+    const size_t& headerLength = buildHeader(header, buffer, length);
+    const size_t& offset = MQTT_MAX_HEADER_SIZE - headerLength;
+    const size_t& packetLength = length + headerLength;
+
+    _lastOutActivity = millis();
+    return (_client->write(buffer + offset, packetLength) == packetLength);
+}
+
+uint16_t PubSubClient::writeString(const char* str, uint8_t* buffer, uint16_t pos)
+{
+    const uint16_t start = pos;
+    pos += 2;
+
+    while (*str && pos < _bufferSize) {
+        buffer[pos++] = *str++;
+    }
+
+    const uint16_t& length = pos - start - 2;
+    buffer[start] = (length >> 8);
+    buffer[start + 1] = (length & 0xFF);
+    return pos;
+}
+
+size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buffer, uint16_t length)
+{
+    uint8_t lengthBuffer[4];
+    uint8_t lengthLength = 0;
+    uint16_t remaining = length;
+
+    do {
+        uint8_t digit = remaining & 127;
+        remaining >>= 7;
+
+        if (remaining > 0) {
+            digit |= 0x80;
+        }
+
+        lengthBuffer[lengthLength++] = digit;
+    } while (remaining > 0);
+
+    // the header is placed right before the variable part of the packet
+    buffer[4 - lengthLength] = header;
+    for (uint8_t i = 0; i < lengthLength; i++) {
+        buffer[MQTT_MAX_HEADER_SIZE - lengthLength + i] = lengthBuffer[i];
+    }
+
+    return lengthLength + 1;
+}
+
+uint16_t PubSubClient::nextPacketId()
+{
+    _nextMsgId++;
+    if (_nextMsgId == 0) {
+        _nextMsgId = 1;
+    }
+
+    return _nextMsgId;
+}
@@ -0,0 +1,154 @@
+#ifndef AHA_HOST_PUBSUBCLIENT_H
+#define AHA_HOST_PUBSUBCLIENT_H
+
+/**
+ * Host replacement of PubSubClient 2.8 that implements the subset of its API
+ * used by the library. Packets are encoded and parsed the same way as in the
+ * original (fixed packet buffer, blocking connect, a single packet read per loop),
+ * so the host build has the same network footprint as the firmware.
+ * Blocking waits consume the virtual time (see HostClock).
+ */
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+
+#define MQTT_VERSION_3_1_1 4
+#define MQTT_VERSION MQTT_VERSION_3_1_1
+
+#ifndef MQTT_MAX_PACKET_SIZE
+#define MQTT_MAX_PACKET_SIZE 256
+#endif
+
+#ifndef MQTT_KEEPALIVE
+#define MQTT_KEEPALIVE 15
+#endif
+
+#ifndef MQTT_SOCKET_TIMEOUT
+#define MQTT_SOCKET_TIMEOUT 15
+#endif
+
+#define MQTT_CONNECTION_TIMEOUT     -4
+#define MQTT_CONNECTION_LOST        -3
+#define MQTT_CONNECT_FAILED         -2
+#define MQTT_DISCONNECTED           -1
+#define MQTT_CONNECTED               0
+#define MQTT_CONNECT_BAD_PROTOCOL    1
+#define MQTT_CONNECT_BAD_CLIENT_ID   2
+#define MQTT_CONNECT_UNAVAILABLE     3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED    5
+
+#define MQTTCONNECT     1 << 4
+#define MQTTCONNACK     2 << 4
+#define MQTTPUBLISH     3 << 4
+#define MQTTPUBACK      4 << 4
+#define MQTTSUBSCRIBE   8 << 4
+#define MQTTUNSUBSCRIBE 10 << 4
+#define MQTTPINGREQ     12 << 4
+#define MQTTPINGRESP    13 << 4
+#define MQTTDISCONNECT  14 << 4
+
+#define MQTTQOS0 (0 << 1)
+#define MQTTQOS1 (1 << 1)
+
+#define MQTT_MAX_HEADER_SIZE 5
+
+#define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+
+class PubSubClient : public Print
+{
+public:
+    PubSubClient();
+    PubSubClient(Client& client);
+    ~PubSubClient();
+
+    PubSubClient& setServer(IPAddress ip, uint16_t port);
+    PubSubClient& setServer(const char* domain, uint16_t port);
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+    PubSubClient& setClient(Client& client);
+    PubSubClient& setKeepAlive(uint16_t keepAlive);
+    PubSubClient& setSocketTimeout(uint16_t timeout);
+
+    boolean setBufferSize(uint16_t size);
+    uint16_t getBufferSize();
+
+    boolean connect(const char* id);
+    boolean connect(const char* id, const char* user, const char* pass);
+    boolean connect(
+        const char* id,
+        const char* willTopic,
+        uint8_t willQos,
+        boolean willRetain,
+        const char* willMessage
+    );
+    boolean connect(
+        const char* id,
+        const char* user,
+        const char* pass,
+        const char* willTopic,
+        uint8_t willQos,
+        boolean willRetain,
+        const char* willMessage
+    );
+    boolean connect(
+        const char* id,
+        const char* user,
+        const char* pass,
+        const char* willTopic,
+        uint8_t willQos,
+        boolean willRetain,
+        const char* willMessage,
+        boolean cleanSession
+    );
+    void disconnect();
+
+    boolean publish(const char* topic, const char* payload);
+    boolean publish(const char* topic, const char* payload, boolean retained);
+    boolean publish(const char* topic, const uint8_t* payload, unsigned int length);
+    boolean publish(
+        const char* topic,
+        const uint8_t* payload,
+        unsigned int length,
+        boolean retained
+    );
+
+    boolean beginPublish(const char* topic, unsigned int length, boolean retained);
+    int endPublish();
+    virtual size_t write(uint8_t c) override;
+    virtual size_t write(const uint8_t* buffer, size_t size) override;
+
+    boolean subscribe(const char* topic);
+    boolean subscribe(const char* topic, uint8_t qos);
+    boolean unsubscribe(const char* topic);
+
+    boolean loop();
+    boolean connected();
+    int state();
+
+private:
+    uint32_t readPacket(uint8_t* lengthLength);
+    boolean readByte(uint8_t* result);
+    boolean readByte(uint8_t* result, uint16_t* index);
+    boolean write(uint8_t header, uint8_t* buffer, uint16_t length);
+    uint16_t writeString(const char* str, uint8_t* buffer, uint16_t pos);
+    size_t buildHeader(uint8_t header, uint8_t* buffer, uint16_t length);
+    uint16_t nextPacketId();
+
+    Client* _client;
+    uint8_t* _buffer;
+    uint16_t _bufferSize;
+    uint16_t _keepAlive;
+    uint16_t _socketTimeout;
+    uint16_t _nextMsgId;
+    uint32_t _lastOutActivity;
+    uint32_t _lastInActivity;
+    bool _pingOutstanding;
+    MQTT_CALLBACK_SIGNATURE;
+    IPAddress _ip;
+    const char* _domain;
+    uint16_t _port;
+    int _state;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include <chrono>
+#include <stdio.h>
+
+#include "HostBench.h"
+#include "HostHeap.h"
+#include "HostStack.h"
+
+// stack used by the measurement itself (std::function call of an empty round)
+static size_t stackOverhead()
+{
+    static size_t overhead = SIZE_MAX;
+
+    if (overhead == SIZE_MAX) {
+        const std::function<void()> empty = []() {};
+
+        HostStack::paint();
+        empty();
+        overhead = HostStack::used();
+    }
+
+    return overhead;
+}
+
+HostBench::HostBench(const char* title, HostClient* client) :
+    _title(title),
+    _client(client),
+    _headerPrinted(false)
+{
+
+}
+
+HostBench::Result HostBench::measure(
+    const char* path,
+    uint32_t entities,
+    uint32_t opsPerRound,
+    uint32_t roundsNb,
+    const std::function<void()>& round
+)
+{
+    Result result;
+    result.path = path;
+    result.entities = entities;
+    result.opsNb = (uint64_t)opsPerRound * roundsNb;
+
+    const size_t overhead = stackOverhead();
+    const size_t liveBytes = HostHeap::getLiveBytes();
+    const uint32_t allocationsNb = HostHeap::getAllocationsNb();
+    HostHeap::resetPeak();
+
+    // warm-up rounds, the second one measures the stack (the first one may grow
+    // buffers of the harness and the host's allocator uses a lot of stack then)
+    round();
+    HostStack::paint();
+    round();
+    const size_t stackBytes = HostStack::used();
+    result.stackBytes = (stackBytes > overhead ? stackBytes - overhead : 0);
+
+    if (_client != nullptr) {
+        _client->resetCounters();
+    }
+
+    // the fastest batch is reported, so warm-up of the CPU doesn't skew the results
+    double nsPerOp = 0;
+    uint32_t measuredRoundsNb = 0;
+
+    for (uint8_t batch = 0; batch < BatchesNb && measuredRoundsNb < roundsNb; batch++) {
+        uint32_t batchRoundsNb = roundsNb / BatchesNb;
+        if (batch == BatchesNb - 1 || batchRoundsNb == 0) {
+            batchRoundsNb = roundsNb - measuredRoundsNb;
+        }
+
+        const uint64_t startedAt = nanos();
+        for (uint32_t i = 0; i < batchRoundsNb; i++) {
+            round();
+        }
+
+        const double batchOpsNb = (opsPerRound > 0 ? (double)opsPerRound * batchRoundsNb : 1);
+        const double batchNsPerOp = (nanos() - startedAt) / batchOpsNb;
+        if (batch == 0 || batchNsPerOp < nsPerOp) {
+            nsPerOp = batchNsPerOp;
+        }
+
+        measuredRoundsNb += batchRoundsNb;
+    }
+
+    const double opsNb = (result.opsNb > 0 ? result.opsNb : 1);
+
+    result.nsPerOp = nsPerOp;
+    result.bytesPerOp = (_client != nullptr ? _client->getBytesWritten() / opsNb : 0);
+    result.writesPerOp = (_client != nullptr ? _client->getWriteCallsNb() / opsNb : 0);
+    result.heapBytes = HostHeap::getPeakBytes() - liveBytes;
+    result.allocationsNb = HostHeap::getAllocationsNb() - allocationsNb;
+
+    print(result);
+    return result;
+}
+
+uint32_t HostBench::roundsFor(uint32_t opsPerRound, uint32_t targetOpsNb)
+{
+    const uint32_t roundsNb = (opsPerRound > 0 ? targetOpsNb / opsPerRound : targetOpsNb);
+    return (roundsNb < 3 ? 3 : roundsNb);
+}
+
+uint64_t HostBench::nanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+void HostBench::printHeader()
+{
+    printf("\n%s\n", _title);
+    printf(
+        "%-22s %8s %10s %10s %9s %9s %8s %7s\n",
+        "path",
+        "entities",
+        "ns/op",
+        "bytes/op",
+        "writes/op",
+        "stack B",
+        "heap B",
+        "allocs"
+    );
+
+    _headerPrinted = true;
+}
+
+void HostBench::print(const Result& result)
+{
+    if (!_headerPrinted) {
+        printHeader();
+    }
+
+    printf(
+        "%-22s %8u %10.1f %10.1f %9.2f %9zu %8zu %7u\n",
+        result.path,
+        result.entities,
+        result.nsPerOp,
+        result.bytesPerOp,
+        result.writesPerOp,
+        result.stackBytes,
+        result.heapBytes,
+        result.allocationsNb
+    );
+    fflush(stdout);
+}
@@ -0,0 +1,79 @@
+#ifndef AHA_HOSTBENCH_H
+#define AHA_HOSTBENCH_H
+
+#include <functional>
+#include <stdint.h>
+
+#include "HostClient.h"
+
+/**
+ * Runs benchmarks of the library and prints their results as a table.
+ * Each benchmark is a round of operations (e.g. publishing state of all entities)
+ * that's repeated a few times. Time is measured with the host's monotonic clock
+ * (the fastest of BatchesNb batches of rounds is reported),
+ * network footprint with HostClient's counters, stack with HostStack and heap with HostHeap.
+ */
+class HostBench
+{
+public:
+    static const uint8_t BatchesNb = 5;
+
+    struct Result {
+        const char* path;
+        uint32_t entities;
+        uint64_t opsNb;
+        double nsPerOp;
+        double bytesPerOp;
+        double writesPerOp;
+        size_t stackBytes;
+        size_t heapBytes;
+        uint32_t allocationsNb;
+    };
+
+    /**
+     * @param title Title printed above the table.
+     * @param client Client whose writes are counted (may be changed with `setClient`).
+     */
+    HostBench(const char* title, HostClient* client = nullptr);
+
+    inline void setClient(HostClient* client)
+        { _client = client; }
+
+    /**
+     * Measures the given round of operations and prints the result.
+     *
+     * @param path Name of the measured publish path.
+     * @param entities Number of entities registered in the library.
+     * @param opsPerRound Number of operations performed by a single round.
+     * @param roundsNb Number of measured rounds.
+     * @param round The round.
+     */
+    Result measure(
+        const char* path,
+        uint32_t entities,
+        uint32_t opsPerRound,
+        uint32_t roundsNb,
+        const std::function<void()>& round
+    );
+
+    /**
+     * Returns number of rounds so that the benchmark performs about
+     * the given number of operations in total (at least 3 rounds).
+     */
+    static uint32_t roundsFor(uint32_t opsPerRound, uint32_t targetOpsNb = 10000);
+
+    /**
+     * Returns time of the host's monotonic clock in nanoseconds.
+     */
+    static uint64_t nanos();
+
+private:
+    void printHeader();
+    void print(const Result& result);
+
+    const char* _title;
+    HostClient* _client;
+    bool _headerPrinted;
+};
+
+#endif
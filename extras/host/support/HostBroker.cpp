@@ -0,0 +1,539 @@
+#include <string.h>
+
+#include "HostBroker.h"
+#include "HostClock.h"
+
+// flags of the CONNECT packet
+static const uint8_t ConnectCleanSession = 0x02;
+static const uint8_t ConnectWill = 0x04;
+static const uint8_t ConnectWillRetain = 0x20;
+static const uint8_t ConnectPassword = 0x40;
+static const uint8_t ConnectUsername = 0x80;
+
+HostBroker::HostBroker() :
+    _deliveriesNb(0)
+{
+    resetCounters();
+}
+
+void HostBroker::subscribe(const std::string& filter, const Listener& listener)
+{
+    Listening listening;
+    listening.filter = filter;
+    listening.listener = listener;
+    _listenings.push_back(listening);
+
+    for (auto it = _retained.begin(); it != _retained.end(); ++it) {
+        if (matches(filter, it->first)) {
+            _deliveriesNb++;
+            listener(it->second);
+        }
+    }
+}
+
+void HostBroker::publish(
+    const std::string& topic,
+    const std::string& payload,
+    uint8_t qos,
+    bool retained
+)
+{
+    HostMessage message;
+    message.topic = topic;
+    message.payload = payload;
+    message.qos = qos;
+    message.retained = retained;
+
+    route(message);
+}
+
+void HostBroker::loop()
+{
+    const uint64_t now = HostClock::now();
+    std::vector<HostClient*> expired;
+
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (it->session == nullptr || it->keepAlive == 0) {
+            continue;
+        }
+
+        if (now - it->lastActivity > it->keepAlive * 1500000ULL) {
+            expired.push_back(it->client);
+        }
+    }
+
+    for (size_t i = 0; i < expired.size(); i++) {
+        expired[i]->drop();
+        close(*expired[i], false);
+    }
+}
+
+const HostMessage* HostBroker::getRetained(const std::string& topic) const
+{
+    auto it = _retained.find(topic);
+    return (it == _retained.end() ? nullptr : &it->second);
+}
+
+size_t HostBroker::getConnectedNb() const
+{
+    size_t connectedNb = 0;
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (it->session != nullptr) {
+            connectedNb++;
+        }
+    }
+
+    return connectedNb;
+}
+
+void HostBroker::resetCounters()
+{
+    memset(_packetsNb, 0, sizeof(_packetsNb));
+    _deliveriesNb = 0;
+}
+
+bool HostBroker::matches(const std::string& filter, const std::string& topic)
+{
+    // wildcards don't match topics of the broker itself (e.g. $SYS)
+    if (!topic.empty() && topic[0] == '$' && !filter.empty() &&
+            (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+
+    size_t f = 0;
+    size_t t = 0;
+
+    while (f < filter.size()) {
+        if (filter[f] == '#') {
+            return true;
+        }
+
+        if (filter[f] == '+') {
+            while (t < topic.size() && topic[t] != '/') {
+                t++;
+            }
+
+            f++;
+        } else {
+            if (t >= topic.size() || filter[f] != topic[t]) {
+                // "a/#" matches "a" as well
+                return (
+                    t == topic.size() &&
+                    filter.compare(f, std::string::npos, "/#") == 0
+                );
+            }
+
+            f++;
+            t++;
+        }
+    }
+
+    return (t == topic.size());
+}
+
+bool HostBroker::onClientConnect(HostClient& client)
+{
+    // the previous connection was lost without the broker noticing it
+    if (findConnection(client) != nullptr) {
+        close(client, false);
+    }
+
+    Connection connection;
+    connection.client = &client;
+    connection.session = nullptr;
+    connection.keepAlive = 0;
+    connection.lastActivity = HostClock::now();
+    connection.hasWill = false;
+
+    _connections.push_back(connection);
+    return true;
+}
+
+void HostBroker::onClientData(HostClient& client, const uint8_t* data, size_t length)
+{
+    Connection* connection = findConnection(client);
+    if (connection == nullptr) {
+        return;
+    }
+
+    connection->reader.append(data, length);
+
+    // the connection may be closed by any of the packets
+    HostPacket packet;
+    while ((connection = findConnection(client)) != nullptr &&
+            connection->reader.next(packet)) {
+        processPacket(*connection, packet);
+    }
+}
+
+void HostBroker::onClientClose(HostClient& client)
+{
+    close(client, false);
+}
+
+HostBroker::Connection* HostBroker::findConnection(HostClient& client)
+{
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (it->client == &client) {
+            return &(*it);
+        }
+    }
+
+    return nullptr;
+}
+
+void HostBroker::processPacket(Connection& connection, const HostPacket& packet)
+{
+    _packetsNb[packet.type() >> 4]++;
+    connection.lastActivity = HostClock::now();
+
+    if (connection.session == nullptr && packet.type() != HostPacket::TypeConnect) {
+        return;
+    }
+
+    switch (packet.type()) {
+    case HostPacket::TypeConnect:
+        processConnect(connection, packet);
+        break;
+
+    case HostPacket::TypePublish:
+        processPublish(connection, packet);
+        break;
+
+    case HostPacket::TypeSubscribe:
+        processSubscribe(connection, packet);
+        break;
+
+    case HostPacket::TypeUnsubscribe:
+        processUnsubscribe(connection, packet);
+        break;
+
+    case HostPacket::TypePingReq:
+        connection.client->deliver(HostPacket::encode(HostPacket::TypePingResp, std::string()));
+        break;
+
+    case HostPacket::TypeDisconnect: {
+        HostClient& client = *connection.client;
+        client.drop();
+        close(client, true);
+        break;
+    }
+
+    case HostPacket::TypePubAck:
+        connection.session->inFlight.erase(HostPacket::decodeUint16(packet.body, 0));
+        break;
+
+    default:
+        break;
+    }
+}
+
+void HostBroker::processConnect(Connection& connection, const HostPacket& packet)
+{
+    size_t offset = 0;
+    HostPacket::decodeString(packet.body, offset); // protocol name
+    offset++; // protocol level
+
+    const uint8_t flags = (offset < packet.body.size() ? packet.body[offset] : 0);
+    offset++;
+
+    connection.keepAlive = HostPacket::decodeUint16(packet.body, offset);
+    offset += 2;
+
+    const std::string clientId = HostPacket::decodeString(packet.body, offset);
+
+    if (flags & ConnectWill) {
+        connection.hasWill = true;
+        connection.will.topic = HostPacket::decodeString(packet.body, offset);
+        connection.will.payload = HostPacket::decodeString(packet.body, offset);
+        connection.will.qos = (flags >> 3) & 0x03;
+        connection.will.retained = (flags & ConnectWillRetain);
+    }
+
+    if (flags & ConnectUsername) {
+        HostPacket::decodeString(packet.body, offset);
+    }
+
+    if (flags & ConnectPassword) {
+        HostPacket::decodeString(packet.body, offset);
+    }
+
+    // session take over
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (&(*it) != &connection && it->session != nullptr &&
+                it->session->clientId == clientId) {
+            HostClient& client = *it->client;
+            client.drop();
+            close(client, false);
+            break;
+        }
+    }
+
+    const bool clean = (flags & ConnectCleanSession);
+    Session* session = nullptr;
+
+    for (auto it = _sessions.begin(); it != _sessions.end(); ++it) {
+        if (it->clientId == clientId) {
+            if (clean) {
+                _sessions.erase(it);
+            } else {
+                session = &(*it);
+            }
+
+            break;
+        }
+    }
+
+    const bool sessionPresent = (session != nullptr);
+    if (session == nullptr) {
+        Session newSession;
+        newSession.clientId = clientId;
+        newSession.nextPacketId = 1;
+
+        _sessions.push_back(newSession);
+        session = &_sessions.back();
+    }
+
+    session->clean = clean;
+    connection.session = session;
+
+    std::string connAck;
+    connAck.push_back((char)(sessionPresent ? 0x01 : 0x00));
+    connAck.push_back(0x00); // accepted
+    connection.client->deliver(HostPacket::encode(HostPacket::TypeConnAck, connAck));
+
+    // unacknowledged messages of the previous connection are sent again
+    std::map<uint16_t, HostMessage> inFlight;
+    inFlight.swap(session->inFlight);
+
+    for (auto it = inFlight.begin(); it != inFlight.end(); ++it) {
+        deliver(connection, it->second, 1, true);
+    }
+
+    for (size_t i = 0; i < session->pending.size(); i++) {
+        deliver(connection, session->pending[i], session->pending[i].qos);
+    }
+
+    session->pending.clear();
+}
+
+void HostBroker::processPublish(Connection& connection, const HostPacket& packet)
+{
+    size_t offset = 0;
+    HostMessage message;
+    message.topic = HostPacket::decodeString(packet.body, offset);
+    message.qos = packet.qos();
+    message.retained = packet.retained();
+
+    if (message.qos > 0) {
+        const uint16_t packetId = HostPacket::decodeUint16(packet.body, offset);
+        offset += 2;
+
+        connection.client->deliver(HostPacket::encode(
+            HostPacket::TypePubAck,
+            HostPacket::encodeUint16(packetId)
+        ));
+    }
+
+    message.payload = packet.body.substr(offset);
+    route(message);
+}
+
+void HostBroker::processSubscribe(Connection& connection, const HostPacket& packet)
+{
+    size_t offset = 2; // packet ID
+    std::string subAck = packet.body.substr(0, 2);
+    std::vector<Subscription> added;
+
+    while (offset < packet.body.size()) {
+        Subscription subscription;
+        subscription.filter = HostPacket::decodeString(packet.body, offset);
+        subscription.qos = (offset < packet.body.size() ? packet.body[offset] : 0);
+        offset++;
+
+        if (subscription.qos > 1) {
+            subscription.qos = 1; // QoS 2 isn't supported
+        }
+
+        std::vector<Subscription>& subscriptions = connection.session->subscriptions;
+        bool replaced = false;
+
+        for (size_t i = 0; i < subscriptions.size(); i++) {
+            if (subscriptions[i].filter == subscription.filter) {
+                subscriptions[i].qos = subscription.qos;
+                replaced = true;
+                break;
+            }
+        }
+
+        if (!replaced) {
+            subscriptions.push_back(subscription);
+        }
+
+        subAck.push_back((char)subscription.qos);
+        added.push_back(subscription);
+    }
+
+    connection.client->deliver(HostPacket::encode(HostPacket::TypeSubAck, subAck));
+
+    for (size_t i = 0; i < added.size(); i++) {
+        for (auto it = _retained.begin(); it != _retained.end(); ++it) {
+            if (matches(added[i].filter, it->first)) {
+                const uint8_t qos = (it->second.qos < added[i].qos ? it->second.qos : added[i].qos);
+                deliver(connection, it->second, qos);
+            }
+        }
+    }
+}
+
+void HostBroker::processUnsubscribe(Connection& connection, const HostPacket& packet)
+{
+    size_t offset = 2; // packet ID
+    std::vector<Subscription>& subscriptions = connection.session->subscriptions;
+
+    while (offset < packet.body.size()) {
+        const std::string filter = HostPacket::decodeString(packet.body, offset);
+
+        for (size_t i = 0; i < subscriptions.size(); i++) {
+            if (subscriptions[i].filter == filter) {
+                subscriptions.erase(subscriptions.begin() + i);
+                break;
+            }
+        }
+    }
+
+    connection.client->deliver(HostPacket::encode(
+        HostPacket::TypeUnsubAck,
+        packet.body.substr(0, 2)
+    ));
+}
+
+void HostBroker::route(const HostMessage& message)
+{
+    if (message.retained) {
+        if (message.payload.empty()) {
+            _retained.erase(message.topic);
+        } else {
+            _retained[message.topic] = message;
+        }
+    }
+
+    // subscriptions that already exist get the message without the retain flag
+    HostMessage routed = message;
+    routed.retained = false;
+
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (it->session == nullptr) {
+            continue;
+        }
+
+        int qos = -1;
+        const std::vector<Subscription>& subscriptions = it->session->subscriptions;
+        for (size_t i = 0; i < subscriptions.size(); i++) {
+            if (subscriptions[i].qos > qos && matches(subscriptions[i].filter, routed.topic)) {
+                qos = subscriptions[i].qos;
+            }
+        }
+
+        if (qos >= 0) {
+            deliver(*it, routed, (message.qos < qos ? message.qos : qos));
+        }
+    }
+
+    // persistent sessions of disconnected clients keep QoS 1 messages
+    if (message.qos > 0) {
+        for (auto it = _sessions.begin(); it != _sessions.end(); ++it) {
+            bool connected = false;
+            for (auto c = _connections.begin(); c != _connections.end(); ++c) {
+                if (c->session == &(*it)) {
+                    connected = true;
+                    break;
+                }
+            }
+
+            if (connected || it->clean) {
+                continue;
+            }
+
+            for (size_t i = 0; i < it->subscriptions.size(); i++) {
+                if (it->subscriptions[i].qos > 0 &&
+                        matches(it->subscriptions[i].filter, routed.topic)) {
+                    it->pending.push_back(routed);
+                    break;
+                }
+            }
+        }
+    }
+
+    // listeners may subscribe or publish, so they're accessed by index
+    for (size_t i = 0; i < _listenings.size(); i++) {
+        if (matches(_listenings[i].filter, routed.topic)) {
+            const Listener listener = _listenings[i].listener;
+            _deliveriesNb++;
+            listener(routed);
+        }
+    }
+}
+
+void HostBroker::deliver(
+    Connection& connection,
+    const HostMessage& message,
+    uint8_t qos,
+    bool duplicate
+)
+{
+    uint16_t packetId = 0;
+    if (qos > 0) {
+        Session& session = *connection.session;
+        packetId = session.nextPacketId++;
+        if (session.nextPacketId == 0) {
+            session.nextPacketId = 1;
+        }
+
+        session.inFlight[packetId] = message;
+    }
+
+    std::string packet = HostPacket::publish(
+        message.topic,
+        message.payload,
+        qos,
+        message.retained,
+        packetId
+    );
+
+    if (duplicate) {
+        packet[0] |= 0x08;
+    }
+
+    _deliveriesNb++;
+    connection.client->deliver(packet);
+}
+
+void HostBroker::close(HostClient& client, bool graceful)
+{
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (it->client != &client) {
+            continue;
+        }
+
+        const bool publishWill = (!graceful && it->session != nullptr && it->hasWill);
+        const HostMessage will = it->will;
+
+        if (it->session != nullptr && it->session->clean) {
+            for (auto s = _sessions.begin(); s != _sessions.end(); ++s) {
+                if (&(*s) == it->session) {
+                    _sessions.erase(s);
+                    break;
+                }
+            }
+        }
+
+        _connections.erase(it);
+
+        if (publishWill) {
+            route(will);
+        }
+
+        return;
+    }
+}
@@ -0,0 +1,150 @@
+#ifndef AHA_HOSTBROKER_H
+#define AHA_HOSTBROKER_H
+
+#include <functional>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "HostClient.h"
+#include "HostPacket.h"
+
+/**
+ * In-process stand-in of an MQTT 3.1.1 broker. Any number of HostClients
+ * can be connected to it (e.g. multiple devices), their messages are routed
+ * to the matching subscriptions (including `+` and `#` wildcards).
+ *
+ * The broker keeps retained messages and persistent sessions (subscriptions,
+ * unacknowledged QoS 1 messages and QoS 1 messages of disconnected clients),
+ * publishes last will messages and closes connections whose keep alive expired.
+ * Keep alive is measured by HostClock, so it's checked only in `loop`.
+ *
+ * The harness may subscribe to topics too (e.g. acting as Home Assistant),
+ * its listeners are called synchronously when a message is routed.
+ */
+class HostBroker : public HostPeer
+{
+public:
+    typedef std::function<void(const HostMessage& message)> Listener;
+
+    HostBroker();
+
+    /**
+     * Subscribes the harness to the given topic filter.
+     * Retained messages that match the filter are passed to the listener right away.
+     */
+    void subscribe(const std::string& filter, const Listener& listener);
+
+    /**
+     * Publishes the message on behalf of the harness.
+     */
+    void publish(
+        const std::string& topic,
+        const std::string& payload,
+        uint8_t qos = 0,
+        bool retained = false
+    );
+
+    /**
+     * Closes connections whose keep alive expired (1.5x of the interval).
+     */
+    void loop();
+
+    /**
+     * Returns retained message of the given topic or nullptr if there's none.
+     */
+    const HostMessage* getRetained(const std::string& topic) const;
+
+    inline size_t getRetainedNb() const
+        { return _retained.size(); }
+
+    /**
+     * Returns number of clients that completed the handshake.
+     */
+    size_t getConnectedNb() const;
+
+    /**
+     * Returns number of packets of the given type (see HostPacket) sent by the clients.
+     */
+    inline uint32_t getPacketsNb(uint8_t type) const
+        { return _packetsNb[type >> 4]; }
+
+    /**
+     * Returns number of messages delivered to the clients and the harness' listeners.
+     */
+    inline uint32_t getDeliveriesNb() const
+        { return _deliveriesNb; }
+
+    void resetCounters();
+
+    /**
+     * Returns true if the topic matches the filter (MQTT 3.1.1, section 4.7).
+     */
+    static bool matches(const std::string& filter, const std::string& topic);
+
+    virtual bool onClientConnect(HostClient& client) override;
+    virtual void onClientData(HostClient& client, const uint8_t* data, size_t length) override;
+    virtual void onClientClose(HostClient& client) override;
+
+private:
+    struct Subscription {
+        std::string filter;
+        uint8_t qos;
+    };
+
+    struct Session {
+        std::string clientId;
+        bool clean;
+        std::vector<Subscription> subscriptions;
+        std::vector<HostMessage> pending; // QoS 1 messages for the disconnected client
+        std::map<uint16_t, HostMessage> inFlight; // delivered QoS 1 messages until PUBACK
+        uint16_t nextPacketId;
+    };
+
+    struct Connection {
+        HostClient* client;
+        HostPacketReader reader;
+        Session* session; // nullptr until CONNECT is received
+        uint16_t keepAlive; // seconds
+        uint64_t lastActivity;
+        bool hasWill;
+        HostMessage will;
+    };
+
+    struct Listening {
+        std::string filter;
+        Listener listener;
+    };
+
+    Connection* findConnection(HostClient& client);
+    void processPacket(Connection& connection, const HostPacket& packet);
+    void processConnect(Connection& connection, const HostPacket& packet);
+    void processPublish(Connection& connection, const HostPacket& packet);
+    void processSubscribe(Connection& connection, const HostPacket& packet);
+    void processUnsubscribe(Connection& connection, const HostPacket& packet);
+
+    /**
+     * Stores the retained message and passes it to the subscribers.
+     */
+    void route(const HostMessage& message);
+    void deliver(
+        Connection& connection,
+        const HostMessage& message,
+        uint8_t qos,
+        bool duplicate = false
+    );
+
+    /**
+     * Forgets the connection, publishes its will unless the client disconnected gracefully.
+     */
+    void close(HostClient& client, bool graceful);
+
+    std::list<Connection> _connections;
+    std::list<Session> _sessions;
+    std::vector<Listening> _listenings;
+    std::map<std::string, HostMessage> _retained;
+    uint32_t _packetsNb[16];
+    uint32_t _deliveriesNb;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "HostClient.h"
+
+HostClient::HostClient() :
+    _peer(nullptr),
+    _connected(false),
+    _refusing(false),
+    _capturing(false),
+    _writeCallsNb(0),
+    _bytesWritten(0),
+    _connectsNb(0)
+{
+
+}
+
+HostClient::HostClient(HostPeer& peer) :
+    HostClient()
+{
+    _peer = &peer;
+}
+
+void HostClient::deliver(const uint8_t* data, size_t length)
+{
+    if (!_connected) {
+        return;
+    }
+
+    _input.insert(_input.end(), data, data + length);
+}
+
+void HostClient::deliver(const std::string& data)
+{
+    deliver((const uint8_t*)data.data(), data.size());
+}
+
+void HostClient::drop()
+{
+    _connected = false;
+    _input.clear();
+}
+
+void HostClient::resetCounters()
+{
+    _writeCallsNb = 0;
+    _bytesWritten = 0;
+}
+
+int HostClient::connect(IPAddress ip, uint16_t port)
+{
+    (void)ip;
+    (void)port;
+
+    return open();
+}
+
+int HostClient::connect(const char* host, uint16_t port)
+{
+    (void)host;
+    (void)port;
+
+    return open();
+}
+
+size_t HostClient::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HostClient::write(const uint8_t* buffer, size_t size)
+{
+    if (!_connected) {
+        return 0;
+    }
+
+    _writeCallsNb++;
+    _bytesWritten += size;
+
+    if (_capturing) {
+        _output.append((const char*)buffer, size);
+    }
+
+    if (_peer != nullptr) {
+        _peer->onClientData(*this, buffer, size);
+    }
+
+    return size;
+}
+
+int HostClient::available()
+{
+    return _input.size();
+}
+
+int HostClient::read()
+{
+    if (_input.empty()) {
+        return -1;
+    }
+
+    const uint8_t c = _input.front();
+    _input.pop_front();
+    return c;
+}
+
+int HostClient::read(uint8_t* buffer, size_t size)
+{
+    if (_input.empty()) {
+        return -1;
+    }
+
+    size_t length = 0;
+    while (length < size && !_input.empty()) {
+        buffer[length++] = _input.front();
+        _input.pop_front();
+    }
+
+    return length;
+}
+
+int HostClient::peek()
+{
+    return (_input.empty() ? -1 : _input.front());
+}
+
+void HostClient::flush()
+{
+
+}
+
+void HostClient::stop()
+{
+    if (!_connected) {
+        return;
+    }
+
+    _connected = false;
+    _input.clear();
+
+    if (_peer != nullptr) {
+        _peer->onClientClose(*this);
+    }
+}
+
+uint8_t HostClient::connected()
+{
+    return (_connected ? 1 : 0);
+}
+
+HostClient::operator bool()
+{
+    return _connected;
+}
+
+int HostClient::open()
+{
+    _connectsNb++;
+
+    if (_refusing || (_peer != nullptr && !_peer->onClientConnect(*this))) {
+        return 0;
+    }
+
+    _connected = true;
+    _input.clear();
+    return 1;
+}
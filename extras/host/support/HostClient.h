@@ -0,0 +1,119 @@
+#ifndef AHA_HOSTCLIENT_H
+#define AHA_HOSTCLIENT_H
+
+#include <deque>
+#include <string>
+
+#include <Client.h>
+
+class HostClient;
+
+/**
+ * Remote side of the HostClient's connection (e.g. a broker).
+ */
+class HostPeer
+{
+public:
+    virtual ~HostPeer() {}
+
+    /**
+     * Called when the client opens the connection.
+     * Returns false if the connection should be refused.
+     */
+    virtual bool onClientConnect(HostClient& client) { (void)client; return true; }
+
+    /**
+     * Called synchronously for each write of the client.
+     */
+    virtual void onClientData(HostClient& client, const uint8_t* data, size_t length) = 0;
+
+    /**
+     * Called when the client closes the connection.
+     */
+    virtual void onClientClose(HostClient& client) { (void)client; }
+};
+
+/**
+ * Network client of the host build that passes the data through loopback buffers.
+ * Written data is delivered to the peer right away and the peer's replies
+ * are available for reading immediately, so blocking clients never wait.
+ * The client counts writes and bytes, so network footprint of the library
+ * can be measured.
+ */
+class HostClient : public Client
+{
+public:
+    HostClient();
+    explicit HostClient(HostPeer& peer);
+
+    inline void setPeer(HostPeer* peer)
+        { _peer = peer; }
+
+    /**
+     * Makes the following connection attempts fail.
+     */
+    inline void setRefusingConnections(bool refusing)
+        { _refusing = refusing; }
+
+    /**
+     * Keeps copy of the written data (see `getOutput`).
+     */
+    inline void setCapturing(bool capturing)
+        { _capturing = capturing; }
+
+    inline const std::string& getOutput() const
+        { return _output; }
+
+    inline void clearOutput()
+        { _output.clear(); }
+
+    /**
+     * Makes the data available for reading by the library.
+     */
+    void deliver(const uint8_t* data, size_t length);
+    void deliver(const std::string& data);
+
+    /**
+     * Breaks the connection without notifying the peer (e.g. lost link).
+     */
+    void drop();
+
+    inline uint32_t getWriteCallsNb() const
+        { return _writeCallsNb; }
+
+    inline uint64_t getBytesWritten() const
+        { return _bytesWritten; }
+
+    inline uint32_t getConnectsNb() const
+        { return _connectsNb; }
+
+    void resetCounters();
+
+    virtual int connect(IPAddress ip, uint16_t port) override;
+    virtual int connect(const char* host, uint16_t port) override;
+    virtual size_t write(uint8_t c) override;
+    virtual size_t write(const uint8_t* buffer, size_t size) override;
+    virtual int available() override;
+    virtual int read() override;
+    virtual int read(uint8_t* buffer, size_t size) override;
+    virtual int peek() override;
+    virtual void flush() override;
+    virtual void stop() override;
+    virtual uint8_t connected() override;
+    virtual operator bool() override;
+
+private:
+    int open();
+
+    HostPeer* _peer;
+    bool _connected;
+    bool _refusing;
+    bool _capturing;
+    std::deque<uint8_t> _input;
+    std::string _output;
+    uint32_t _writeCallsNb;
+    uint64_t _bytesWritten;
+    uint32_t _connectsNb;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "HostClock.h"
+
+uint64_t HostClock::_now = 0;
+
+uint64_t HostClock::now()
+{
+    return _now;
+}
+
+void HostClock::advance(uint32_t ms)
+{
+    _now += (uint64_t)ms * 1000;
+}
+
+void HostClock::advanceMicros(uint32_t us)
+{
+    _now += us;
+}
+
+void HostClock::set(uint64_t us)
+{
+    _now = us;
+}
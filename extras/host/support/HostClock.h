@@ -0,0 +1,38 @@
+#ifndef AHA_HOSTCLOCK_H
+#define AHA_HOSTCLOCK_H
+
+#include <stdint.h>
+
+/**
+ * Virtual clock behind `millis()` and `micros()` of the host build.
+ * The time passes only when it's advanced explicitly (or by `delay`),
+ * so the runs are deterministic and hours of uptime take milliseconds.
+ */
+class HostClock
+{
+public:
+    /**
+     * Returns the current time in microseconds.
+     */
+    static uint64_t now();
+
+    /**
+     * Moves the clock forward by the given number of milliseconds.
+     */
+    static void advance(uint32_t ms);
+
+    /**
+     * Moves the clock forward by the given number of microseconds.
+     */
+    static void advanceMicros(uint32_t us);
+
+    /**
+     * Sets the clock to the given time (in microseconds).
+     */
+    static void set(uint64_t us);
+
+private:
+    static uint64_t _now;
+};
+
+#endif
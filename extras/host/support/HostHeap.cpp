@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "HostHeap.h"
+
+// each block is preceded by its size, aligned the same way as malloc's blocks
+static const size_t HeaderSize = 16;
+
+struct HostHeapSite {
+    const char* file;
+    int line;
+    uint32_t allocationsNb;
+    size_t bytes;
+};
+
+struct HostHeapCall {
+    const char* name;
+    bool steadyState;
+    uint32_t callsNb;
+    uint32_t allocationsNb;
+    size_t bytes;
+    size_t peakLiveBytes;
+    std::vector<HostHeapSite> sites;
+};
+
+static const char* OutsideCall = "(outside of API calls)";
+
+// the harness' containers use the regular heap, so they aren't counted
+static std::vector<HostHeapCall>& calls()
+{
+    static std::vector<HostHeapCall> instance;
+    return instance;
+}
+
+static std::vector<size_t>& scopes()
+{
+    static std::vector<size_t> instance;
+    return instance;
+}
+
+uint32_t HostHeap::_allocationsNb = 0;
+size_t HostHeap::_liveBytes = 0;
+size_t HostHeap::_peakBytes = 0;
+
+static inline void* blockOf(void* ptr)
+{
+    return (uint8_t*)ptr - HeaderSize;
+}
+
+static inline size_t sizeOf(void* ptr)
+{
+    return *(size_t*)blockOf(ptr);
+}
+
+static size_t findCall(const char* name, bool steadyState)
+{
+    std::vector<HostHeapCall>& list = calls();
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i].steadyState == steadyState && strcmp(list[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    HostHeapCall call;
+    call.name = name;
+    call.steadyState = steadyState;
+    call.callsNb = 0;
+    call.allocationsNb = 0;
+    call.bytes = 0;
+    call.peakLiveBytes = 0;
+
+    list.push_back(call);
+    return list.size() - 1;
+}
+
+static const char* shortPath(const char* file)
+{
+    if (file == nullptr) {
+        return "(unknown)";
+    }
+
+    const char* src = strstr(file, "src/");
+    return (src != nullptr ? src + 4 : file);
+}
+
+void HostHeap::beginCall(const char* call, bool steadyState)
+{
+    const size_t index = findCall(call, steadyState);
+    HostHeapCall& entry = calls()[index];
+
+    entry.callsNb++;
+    if (_liveBytes > entry.peakLiveBytes) {
+        entry.peakLiveBytes = _liveBytes;
+    }
+
+    scopes().push_back(index);
+}
+
+void HostHeap::endCall()
+{
+    scopes().pop_back();
+}
+
+void* HostHeap::allocate(size_t size, const char* file, int line)
+{
+    void* block = malloc(HeaderSize + size);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    *(size_t*)block = size;
+    _liveBytes += size;
+    allocated(size, file, line);
+
+    return (uint8_t*)block + HeaderSize;
+}
+
+void* HostHeap::reallocate(void* ptr, size_t size, const char* file, int line)
+{
+    if (ptr == nullptr) {
+        return allocate(size, file, line);
+    }
+
+    const size_t previousSize = sizeOf(ptr);
+    void* block = realloc(blockOf(ptr), HeaderSize + size);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    *(size_t*)block = size;
+    _liveBytes = _liveBytes - previousSize + size;
+    allocated(size, file, line);
+
+    return (uint8_t*)block + HeaderSize;
+}
+
+void HostHeap::release(void* ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+
+    _liveBytes -= sizeOf(ptr);
+    free(blockOf(ptr));
+}
+
+void HostHeap::resetPeak()
+{
+    _peakBytes = _liveBytes;
+}
+
+uint32_t HostHeap::getSteadyStateAllocationsNb()
+{
+    uint32_t allocationsNb = 0;
+
+    const std::vector<HostHeapCall>& list = calls();
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i].steadyState) {
+            allocationsNb += list[i].allocationsNb;
+        }
+    }
+
+    return allocationsNb;
+}
+
+void HostHeap::resetCalls()
+{
+    calls().clear();
+    scopes().clear();
+}
+
+bool HostHeap::printReport()
+{
+    const std::vector<HostHeapCall>& list = calls();
+
+    printf("\nAllocations of the library per API call\n");
+    printf(
+        "%-40s %6s %7s %8s %8s %10s\n",
+        "call",
+        "state",
+        "calls",
+        "allocs",
+        "bytes",
+        "peak live"
+    );
+
+    for (size_t i = 0; i < list.size(); i++) {
+        const HostHeapCall& call = list[i];
+        printf(
+            "%-40s %6s %7u %8u %8zu %10zu\n",
+            call.name,
+            (call.steadyState ? "steady" : "setup"),
+            call.callsNb,
+            call.allocationsNb,
+            call.bytes,
+            call.peakLiveBytes
+        );
+
+        for (size_t j = 0; j < call.sites.size(); j++) {
+            const HostHeapSite& site = call.sites[j];
+            printf(
+                "    at %s:%d: %u allocation(s), %zu bytes\n",
+                shortPath(site.file),
+                site.line,
+                site.allocationsNb,
+                site.bytes
+            );
+        }
+    }
+
+    const uint32_t steadyAllocationsNb = getSteadyStateAllocationsNb();
+    if (steadyAllocationsNb > 0) {
+        printf("FAILED: steady state calls made %u allocation(s)\n", steadyAllocationsNb);
+        return false;
+    }
+
+    printf("Steady state calls made no allocations\n");
+    return true;
+}
+
+void HostHeap::allocated(size_t size, const char* file, int line)
+{
+    _allocationsNb++;
+
+    if (_liveBytes > _peakBytes) {
+        _peakBytes = _liveBytes;
+    }
+
+    std::vector<size_t>& stack = scopes();
+    HostHeapCall& call = calls()[stack.empty() ? findCall(OutsideCall, false) : stack.back()];
+
+    call.allocationsNb++;
+    call.bytes += size;
+
+    if (_liveBytes > call.peakLiveBytes) {
+        call.peakLiveBytes = _liveBytes;
+    }
+
+    for (size_t i = 0; i < call.sites.size(); i++) {
+        HostHeapSite& site = call.sites[i];
+        if (site.line == line && site.file == file) {
+            site.allocationsNb++;
+            site.bytes += size;
+            return;
+        }
+    }
+
+    HostHeapSite site;
+    site.file = file;
+    site.line = line;
+    site.allocationsNb = 1;
+    site.bytes = size;
+    call.sites.push_back(site);
+}
@@ -0,0 +1,87 @@
+#ifndef AHA_HOSTHEAP_H
+#define AHA_HOSTHEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Heap of the host build. The library's allocations are routed here
+ * by ARDUINOHA_MALLOC, ARDUINOHA_REALLOC and ARDUINOHA_FREE (see HostOptions.h),
+ * so they can be counted separately from the harness' own allocations.
+ *
+ * Allocations are attributed to the public API call that's in progress
+ * (see HostHeap::Scope) and to their call site in the library. Calls may be
+ * marked as steady state, i.e. the ones that run all the time once the device
+ * is connected (loop, setValue, etc.). They must not allocate anything,
+ * otherwise the heap fragments over time, and the report fails.
+ */
+class HostHeap
+{
+public:
+    /**
+     * Attributes allocations made during its lifetime to the given API call.
+     * Scopes may be nested, the innermost one takes the allocations.
+     */
+    class Scope
+    {
+    public:
+        inline Scope(const char* call, bool steadyState = false)
+            { beginCall(call, steadyState); }
+
+        inline ~Scope()
+            { endCall(); }
+    };
+
+    /**
+     * Attributes the following allocations to the given API call until `endCall`
+     * (e.g. for constructors of objects that need to outlive the scope).
+     */
+    static void beginCall(const char* call, bool steadyState = false);
+    static void endCall();
+
+    static void* allocate(size_t size, const char* file = nullptr, int line = 0);
+    static void* reallocate(void* ptr, size_t size, const char* file = nullptr, int line = 0);
+    static void release(void* ptr);
+
+    /**
+     * Returns number of allocations (including reallocations) made so far.
+     */
+    static inline uint32_t getAllocationsNb()
+        { return _allocationsNb; }
+
+    static inline size_t getLiveBytes()
+        { return _liveBytes; }
+
+    static inline size_t getPeakBytes()
+        { return _peakBytes; }
+
+    /**
+     * Starts measuring the peak from the current number of live bytes.
+     */
+    static void resetPeak();
+
+    /**
+     * Returns number of allocations made by the steady state calls.
+     */
+    static uint32_t getSteadyStateAllocationsNb();
+
+    /**
+     * Clears the statistics of API calls.
+     */
+    static void resetCalls();
+
+    /**
+     * Prints count, size, call sites and peak live bytes of the allocations
+     * per API call. Returns false if any steady state call allocated memory.
+     */
+    static bool printReport();
+
+private:
+    static void allocated(size_t size, const char* file, int line);
+
+    static uint32_t _allocationsNb;
+    static size_t _liveBytes;
+    static size_t _peakBytes;
+};
+
+#endif
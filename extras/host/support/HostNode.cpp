@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "HostClock.h"
+#include "HostNode.h"
+
+HostNode::HostNode(const char* deviceId) :
+    client(responder),
+    device(deviceId),
+    mqtt(client, device)
+{
+
+}
+
+HostNode::~HostNode()
+{
+    for (size_t i = 0; i < _devicesTypes.size(); i++) {
+        delete _devicesTypes[i];
+    }
+
+    for (size_t i = 0; i < _names.size(); i++) {
+        delete[] _names[i];
+    }
+}
+
+const char* HostNode::name(const char* prefix, uint32_t index)
+{
+    char* str = new char[strlen(prefix) + 12];
+    sprintf(str, "%s_%u", prefix, index);
+
+    _names.push_back(str);
+    return str;
+}
+
+bool HostNode::connect(uint32_t maxLoopsNb)
+{
+    mqtt.begin(IPAddress(127, 0, 0, 1));
+
+    for (uint32_t i = 0; i < maxLoopsNb; i++) {
+        mqtt.loop();
+
+        if (mqtt.isDiscoveryCompleted()) {
+            pump(maxLoopsNb);
+            return true;
+        }
+
+        HostClock::advance(1);
+    }
+
+    return false;
+}
+
+void HostNode::pump(uint32_t maxLoopsNb)
+{
+    for (uint32_t i = 0; i < maxLoopsNb && client.available() > 0; i++) {
+        mqtt.loop();
+    }
+}
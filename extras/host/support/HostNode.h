@@ -0,0 +1,58 @@
+#ifndef AHA_HOSTNODE_H
+#define AHA_HOSTNODE_H
+
+#include <vector>
+
+#include <ArduinoHA.h>
+
+#include "HostClient.h"
+#include "HostResponder.h"
+
+/**
+ * Device running the library against HostResponder.
+ * Devices types added to the node are destroyed with it.
+ */
+class HostNode
+{
+public:
+    explicit HostNode(const char* deviceId = "host_node");
+    ~HostNode();
+
+    /**
+     * Takes ownership of the given device type.
+     */
+    template <typename T>
+    T* add(T* deviceType)
+    {
+        _devicesTypes.push_back(deviceType);
+        return deviceType;
+    }
+
+    /**
+     * Returns name in format [prefix]_[index] that's valid for the node's lifetime.
+     */
+    const char* name(const char* prefix, uint32_t index);
+
+    /**
+     * Connects to the responder and loops until the discovery is completed.
+     * The virtual clock advances by 1 ms in each loop.
+     * Returns false if the discovery didn't complete in the given number of loops.
+     */
+    bool connect(uint32_t maxLoopsNb = 100000);
+
+    /**
+     * Loops until all packets received from the responder are processed.
+     */
+    void pump(uint32_t maxLoopsNb = 100000);
+
+    HostResponder responder;
+    HostClient client;
+    HADevice device;
+    HAMqtt mqtt;
+
+private:
+    std::vector<BaseDeviceType*> _devicesTypes;
+    std::vector<char*> _names;
+};
+
+#endif
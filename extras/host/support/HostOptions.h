@@ -0,0 +1,16 @@
+#ifndef AHA_HOSTOPTIONS_H
+#define AHA_HOSTOPTIONS_H
+
+/**
+ * Options of the library's host build. The header is included before
+ * each source of the library (see CMakeLists.txt), so its definitions
+ * take precedence over the defaults of ArduinoHADefines.h.
+ */
+
+#include "HostHeap.h"
+
+#define ARDUINOHA_MALLOC(size) HostHeap::allocate(size, __FILE__, __LINE__)
+#define ARDUINOHA_REALLOC(ptr, size) HostHeap::reallocate(ptr, size, __FILE__, __LINE__)
+#define ARDUINOHA_FREE(ptr) HostHeap::release(ptr)
+
+#endif
@@ -0,0 +1,113 @@
+#include "HostPacket.h"
+
+HostPacket::HostPacket() :
+    header(0)
+{
+
+}
+
+std::string HostPacket::encode(uint8_t header, const std::string& body)
+{
+    std::string packet(1, (char)header);
+    size_t length = body.size();
+
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+
+        if (length > 0) {
+            digit |= 0x80;
+        }
+
+        packet.push_back((char)digit);
+    } while (length > 0);
+
+    return packet + body;
+}
+
+std::string HostPacket::encodeString(const std::string& str)
+{
+    return encodeUint16(str.size()) + str;
+}
+
+std::string HostPacket::encodeUint16(uint16_t value)
+{
+    std::string data(2, '\0');
+    data[0] = (char)(value >> 8);
+    data[1] = (char)(value & 0xFF);
+    return data;
+}
+
+uint16_t HostPacket::decodeUint16(const std::string& data, size_t offset)
+{
+    if (offset + 2 > data.size()) {
+        return 0;
+    }
+
+    return ((uint8_t)data[offset] << 8) | (uint8_t)data[offset + 1];
+}
+
+std::string HostPacket::decodeString(const std::string& data, size_t& offset)
+{
+    const uint16_t length = decodeUint16(data, offset);
+    if (offset + 2 + length > data.size()) {
+        offset = data.size();
+        return std::string();
+    }
+
+    std::string str = data.substr(offset + 2, length);
+    offset += 2 + length;
+    return str;
+}
+
+std::string HostPacket::publish(
+    const std::string& topic,
+    const std::string& payload,
+    uint8_t qos,
+    bool retained,
+    uint16_t packetId
+)
+{
+    std::string body = encodeString(topic);
+    if (qos > 0) {
+        body += encodeUint16(packetId);
+    }
+
+    body += payload;
+    return encode(TypePublish | (qos << 1) | (retained ? 0x01 : 0x00), body);
+}
+
+void HostPacketReader::append(const uint8_t* data, size_t length)
+{
+    _buffer.append((const char*)data, length);
+}
+
+bool HostPacketReader::next(HostPacket& packet)
+{
+    size_t remainingLength = 0;
+    size_t multiplier = 1;
+    size_t offset = 1;
+
+    while (true) {
+        if (offset >= _buffer.size() || offset > 4) {
+            return false;
+        }
+
+        const uint8_t digit = _buffer[offset++];
+        remainingLength += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+
+        if ((digit & 0x80) == 0) {
+            break;
+        }
+    }
+
+    if (_buffer.size() < offset + remainingLength) {
+        return false;
+    }
+
+    packet.header = _buffer[0];
+    packet.body = _buffer.substr(offset, remainingLength);
+    _buffer.erase(0, offset + remainingLength);
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef AHA_HOSTPACKET_H
+#define AHA_HOSTPACKET_H
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Application message carried by the PUBLISH packets.
+ */
+struct HostMessage {
+    std::string topic;
+    std::string payload;
+    uint8_t qos;
+    bool retained;
+};
+
+/**
+ * MQTT 3.1.1 control packet as seen by the remote side of the connection.
+ */
+class HostPacket
+{
+public:
+    static const uint8_t TypeConnect = 0x10;
+    static const uint8_t TypeConnAck = 0x20;
+    static const uint8_t TypePublish = 0x30;
+    static const uint8_t TypePubAck = 0x40;
+    static const uint8_t TypeSubscribe = 0x80;
+    static const uint8_t TypeSubAck = 0x90;
+    static const uint8_t TypeUnsubscribe = 0xA0;
+    static const uint8_t TypeUnsubAck = 0xB0;
+    static const uint8_t TypePingReq = 0xC0;
+    static const uint8_t TypePingResp = 0xD0;
+    static const uint8_t TypeDisconnect = 0xE0;
+
+    HostPacket();
+
+    inline uint8_t type() const
+        { return (header & 0xF0); }
+
+    inline uint8_t qos() const
+        { return ((header >> 1) & 0x03); }
+
+    inline bool retained() const
+        { return (header & 0x01); }
+
+    /**
+     * Encodes the packet with the given fixed header and body.
+     */
+    static std::string encode(uint8_t header, const std::string& body);
+
+    /**
+     * Encodes the string with its length prefix.
+     */
+    static std::string encodeString(const std::string& str);
+
+    static std::string encodeUint16(uint16_t value);
+
+    static uint16_t decodeUint16(const std::string& data, size_t offset);
+
+    /**
+     * Decodes length-prefixed string at the given offset and moves the offset past it.
+     */
+    static std::string decodeString(const std::string& data, size_t& offset);
+
+    static std::string publish(
+        const std::string& topic,
+        const std::string& payload,
+        uint8_t qos = 0,
+        bool retained = false,
+        uint16_t packetId = 0
+    );
+
+    uint8_t header;
+    std::string body; // variable header and payload
+};
+
+/**
+ * Splits the stream of bytes into MQTT packets.
+ */
+class HostPacketReader
+{
+public:
+    void append(const uint8_t* data, size_t length);
+
+    /**
+     * Takes the next complete packet from the stream.
+     * Returns false if the packet isn't complete yet.
+     */
+    bool next(HostPacket& packet);
+
+    inline void reset()
+        { _buffer.clear(); }
+
+private:
+    std::string _buffer;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include <string.h>
+
+#include "HostResponder.h"
+
+HostResponder::HostResponder() :
+    _client(nullptr),
+    _sessionPresent(false),
+    _returnCode(0),
+    _acknowledging(true),
+    _recording(false),
+    _nextPacketId(1)
+{
+    resetCounters();
+}
+
+uint32_t HostResponder::getPacketsNb(uint8_t type) const
+{
+    return _packetsNb[type >> 4];
+}
+
+void HostResponder::resetCounters()
+{
+    memset(_packetsNb, 0, sizeof(_packetsNb));
+}
+
+void HostResponder::publish(
+    const std::string& topic,
+    const std::string& payload,
+    uint8_t qos,
+    bool retained
+)
+{
+    if (_client == nullptr) {
+        return;
+    }
+
+    _client->deliver(HostPacket::publish(topic, payload, qos, retained, _nextPacketId++));
+}
+
+bool HostResponder::onClientConnect(HostClient& client)
+{
+    _client = &client;
+    _reader.reset();
+    return true;
+}
+
+void HostResponder::onClientData(HostClient& client, const uint8_t* data, size_t length)
+{
+    _reader.append(data, length);
+
+    HostPacket packet;
+    while (_reader.next(packet)) {
+        processPacket(client, packet);
+    }
+}
+
+void HostResponder::onClientClose(HostClient& client)
+{
+    if (_client == &client) {
+        _client = nullptr;
+    }
+}
+
+void HostResponder::processPacket(HostClient& client, const HostPacket& packet)
+{
+    _packetsNb[packet.type() >> 4]++;
+
+    switch (packet.type()) {
+    case HostPacket::TypeConnect: {
+        std::string connAck;
+        connAck.push_back((char)(_sessionPresent ? 0x01 : 0x00));
+        connAck.push_back((char)_returnCode);
+        client.deliver(HostPacket::encode(HostPacket::TypeConnAck, connAck));
+        break;
+    }
+
+    case HostPacket::TypePublish: {
+        size_t offset = 0;
+        HostMessage message;
+        message.topic = HostPacket::decodeString(packet.body, offset);
+        message.qos = packet.qos();
+        message.retained = packet.retained();
+
+        if (message.qos > 0) {
+            const uint16_t packetId = HostPacket::decodeUint16(packet.body, offset);
+            offset += 2;
+
+            if (_acknowledging) {
+                client.deliver(HostPacket::encode(
+                    HostPacket::TypePubAck,
+                    HostPacket::encodeUint16(packetId)
+                ));
+            }
+        }
+
+        if (_recording) {
+            message.payload = packet.body.substr(offset);
+            _messages.push_back(message);
+        }
+        break;
+    }
+
+    case HostPacket::TypeSubscribe: {
+        // packet ID and granted QoS of the single topic
+        std::string subAck = packet.body.substr(0, 2);
+        subAck.push_back(packet.body.empty() ? 0 : packet.body[packet.body.size() - 1]);
+        client.deliver(HostPacket::encode(HostPacket::TypeSubAck, subAck));
+        break;
+    }
+
+    case HostPacket::TypeUnsubscribe:
+        client.deliver(HostPacket::encode(HostPacket::TypeUnsubAck, packet.body.substr(0, 2)));
+        break;
+
+    case HostPacket::TypePingReq:
+        client.deliver(HostPacket::encode(HostPacket::TypePingResp, std::string()));
+        break;
+
+    case HostPacket::TypeDisconnect:
+        client.stop();
+        break;
+
+    default:
+        break;
+    }
+}
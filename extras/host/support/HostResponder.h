@@ -0,0 +1,85 @@
+#ifndef AHA_HOSTRESPONDER_H
+#define AHA_HOSTRESPONDER_H
+
+#include <vector>
+
+#include "HostClient.h"
+#include "HostPacket.h"
+
+/**
+ * Minimal remote side of a single MQTT connection. It accepts the connection,
+ * acknowledges subscriptions and QoS 1 messages and answers pings, so
+ * the library can run its whole lifecycle against HostClient.
+ * Published messages are counted and optionally recorded.
+ */
+class HostResponder : public HostPeer
+{
+public:
+    HostResponder();
+
+    /**
+     * Sets the "session present" flag of the following CONNACK packets.
+     */
+    inline void setSessionPresent(bool present)
+        { _sessionPresent = present; }
+
+    /**
+     * Sets return code of the following CONNACK packets (0 means accepted).
+     */
+    inline void setReturnCode(uint8_t code)
+        { _returnCode = code; }
+
+    /**
+     * Determines whether QoS 1 messages are acknowledged right away.
+     */
+    inline void setAcknowledging(bool acknowledging)
+        { _acknowledging = acknowledging; }
+
+    inline void setRecording(bool recording)
+        { _recording = recording; }
+
+    inline const std::vector<HostMessage>& getMessages() const
+        { return _messages; }
+
+    inline void clearMessages()
+        { _messages.clear(); }
+
+    /**
+     * Returns number of packets of the given type (see HostPacket) sent by the client.
+     */
+    uint32_t getPacketsNb(uint8_t type) const;
+
+    inline uint32_t getPublishesNb() const
+        { return getPacketsNb(HostPacket::TypePublish); }
+
+    void resetCounters();
+
+    /**
+     * Sends message to the client that's connected to the responder.
+     */
+    void publish(
+        const std::string& topic,
+        const std::string& payload,
+        uint8_t qos = 0,
+        bool retained = false
+    );
+
+    virtual bool onClientConnect(HostClient& client) override;
+    virtual void onClientData(HostClient& client, const uint8_t* data, size_t length) override;
+    virtual void onClientClose(HostClient& client) override;
+
+private:
+    void processPacket(HostClient& client, const HostPacket& packet);
+
+    HostClient* _client;
+    HostPacketReader _reader;
+    bool _sessionPresent;
+    uint8_t _returnCode;
+    bool _acknowledging;
+    bool _recording;
+    uint16_t _nextPacketId;
+    uint32_t _packetsNb[16];
+    std::vector<HostMessage> _messages;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#include <stdint.h>
+
+#include "HostStack.h"
+
+static const uint8_t Pattern = 0xA5;
+
+// addresses of the painted region (it's outside of any frame once painted)
+static uintptr_t paintedBottom = 0;
+static uintptr_t paintedTop = 0;
+
+__attribute__((noinline)) void HostStack::paint()
+{
+    volatile uint8_t region[Depth];
+    for (size_t i = 0; i < Depth; i++) {
+        region[i] = Pattern;
+    }
+
+    paintedBottom = (uintptr_t)region;
+    paintedTop = (uintptr_t)(region + Depth);
+}
+
+__attribute__((noinline)) size_t HostStack::used()
+{
+    if (paintedBottom == 0) {
+        return 0;
+    }
+
+    // the stack grows down, so the deepest write is the lowest changed address
+    uintptr_t address = paintedBottom;
+    while (address < paintedTop && *(volatile uint8_t*)address == Pattern) {
+        address++;
+    }
+
+    return (paintedTop - address);
+}
@@ -0,0 +1,28 @@
+#ifndef AHA_HOSTSTACK_H
+#define AHA_HOSTSTACK_H
+
+#include <stddef.h>
+
+/**
+ * Measures stack usage by painting the unused part of the stack with a pattern
+ * and looking for the deepest byte that was overwritten afterwards.
+ * Both methods need to be called from the same function, e.g.:
+ *
+ *     HostStack::paint();
+ *     sensor.setValue(1);
+ *     size_t used = HostStack::used();
+ */
+class HostStack
+{
+public:
+    static const size_t Depth = 64 * 1024; // bytes
+
+    static void paint();
+
+    /**
+     * Returns number of bytes used below the caller's frame since `paint`.
+     */
+    static size_t used();
+};
+
+#endif
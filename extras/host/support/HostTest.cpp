@@ -0,0 +1,3 @@
+#include "HostTest.h"
+
+int hostTestFailuresNb = 0;
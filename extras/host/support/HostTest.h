@@ -0,0 +1,42 @@
+#ifndef AHA_HOSTTEST_H
+#define AHA_HOSTTEST_H
+
+#include <stdio.h>
+
+/**
+ * Assertions of the host tests. A failed check is reported and counted,
+ * and HOST_TEST_RESULT() turns the number of failures into the exit code.
+ */
+
+extern int hostTestFailuresNb;
+
+#define HOST_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            hostTestFailuresNb++; \
+        } \
+    } while (0)
+
+#define HOST_CHECK_EQUAL(expected, actual) \
+    do { \
+        const long long expectedValue = (long long)(expected); \
+        const long long actualValue = (long long)(actual); \
+        if (expectedValue != actualValue) { \
+            printf( \
+                "%s:%d: check failed: %s == %s (%lld != %lld)\n", \
+                __FILE__, \
+                __LINE__, \
+                #expected, \
+                #actual, \
+                expectedValue, \
+                actualValue \
+            ); \
+            hostTestFailuresNb++; \
+        } \
+    } while (0)
+
+#define HOST_TEST_RESULT() \
+    (hostTestFailuresNb == 0 ? (printf("OK\n"), 0) : (printf("%d check(s) failed\n", hostTestFailuresNb), 1))
+
+#endif
@@ -0,0 +1,161 @@
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostHeap.h"
+#include "HostResponder.h"
+#include "HostTest.h"
+
+// Tracks allocations of the library per public API call. Setup of the device
+// may allocate, but an hour of steady state (loop, states, commands, pings
+// and a reconnect) must not allocate anything.
+
+static const uint32_t SteadyStateDuration = 3600; // seconds
+
+static uint32_t commandsNb = 0;
+static bool lastCommand = false;
+
+static void onRelayStateChanged(bool state, HASwitch*)
+{
+    commandsNb++;
+    lastCommand = state;
+}
+
+static void loopFor(HAMqtt& mqtt, uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i += 10) {
+        HostHeap::Scope scope("HAMqtt::loop", true);
+        mqtt.loop();
+        HostClock::advance(10);
+    }
+}
+
+static void run(HostResponder& responder, HostClient& client)
+{
+    const byte mac[] = {0x00, 0x10, 0xFA, 0x6E, 0x38, 0x4A};
+
+    // objects are automatic, so the calls are attributed manually
+    HostHeap::beginCall("HADevice(const byte*, uint16_t)");
+    HADevice device(mac, sizeof(mac));
+    device.enableSharedAvailability();
+    device.enableLastWill();
+    HostHeap::endCall();
+
+    HostHeap::beginCall("HAMqtt(Client&, HADevice&)");
+    HAMqtt mqtt(client, device);
+    HostHeap::endCall();
+
+    HostHeap::beginCall("device types' constructors");
+    HASensor<float> sensor("temperature", 0, mqtt);
+    HABinarySensor binarySensor("door", false, mqtt);
+    HASwitch relay("relay", false, mqtt);
+    HATriggers triggers(mqtt);
+    HATagScanner scanner("reader", mqtt);
+    HADiagnostics diagnostics(mqtt);
+    HostHeap::endCall();
+
+    relay.onStateChanged(onRelayStateChanged);
+
+    {
+        HostHeap::Scope scope("HATriggers::add");
+        triggers.add("button_short_press", "button_1");
+        triggers.add("button_long_press", "button_1");
+    }
+
+    {
+        HostHeap::Scope scope("HAMqtt::begin");
+        mqtt.begin(IPAddress(127, 0, 0, 1));
+    }
+
+    for (int i = 0; i < 10000 && !mqtt.isDiscoveryCompleted(); i++) {
+        HostHeap::Scope scope("HAMqtt::loop (first connection)");
+        mqtt.loop();
+        HostClock::advance(1);
+    }
+
+    HOST_CHECK(mqtt.isDiscoveryCompleted());
+
+    // steady state
+    uint32_t sentCommandsNb = 0;
+    for (uint32_t second = 0; second < SteadyStateDuration; second += 10) {
+        loopFor(mqtt, 10000);
+
+        {
+            HostHeap::Scope scope("HASensor::setValue", true);
+            sensor.setValue(second / 100.0f);
+        }
+
+        {
+            HostHeap::Scope scope("HABinarySensor::setState", true);
+            binarySensor.setState(second % 20 == 0);
+        }
+
+        {
+            HostHeap::Scope scope("HATriggers::trigger", true);
+            triggers.trigger("button_short_press", "button_1");
+        }
+
+        {
+            HostHeap::Scope scope("HATagScanner::tagScanned", true);
+            scanner.tagScanned("a1b2c3d4");
+        }
+
+        // acknowledgements of QoS 1 messages free the in-flight table, so the queue
+        // is published before the command arrives (the echo can't overtake it)
+        while (client.available() > 0) {
+            HostHeap::Scope scope("HAMqtt::loop (acknowledgements)", true);
+            mqtt.loop();
+        }
+
+        if (mqtt.isConnected()) {
+            responder.publish("homeassistant/switch/0010fa6e384a/relay/cmd", (second % 20 == 0 ? "ON" : "OFF"));
+            sentCommandsNb++;
+
+            // PubSubClient reads a single packet per loop
+            while (client.available() > 0) {
+                HostHeap::Scope scope("HAMqtt::loop (command)", true);
+                mqtt.loop();
+            }
+        }
+
+        if (second == SteadyStateDuration / 4) {
+            HostHeap::Scope scope("HAMqtt::setPublishQoS", true);
+            mqtt.setPublishQoS(1);
+        }
+
+        if (second == SteadyStateDuration / 2) {
+            HostHeap::Scope scope("HAMqtt::setDeferredPublishing", true);
+            mqtt.setDeferredPublishing(true);
+        }
+
+        if (second == SteadyStateDuration * 3 / 4) {
+            // lost connection, the reconnect and the discovery are steady state too
+            client.drop();
+        }
+    }
+
+    HOST_CHECK(mqtt.isConnected());
+    HOST_CHECK(client.getConnectsNb() == 2);
+    HOST_CHECK(sentCommandsNb > 0);
+    HOST_CHECK_EQUAL(sentCommandsNb, commandsNb);
+    HOST_CHECK(relay.getState() == lastCommand);
+
+    // destructors of the objects run when the function returns
+    HostHeap::beginCall("destructors");
+}
+
+int main()
+{
+    HostResponder responder;
+    HostClient client(responder);
+
+    run(responder, client);
+    HostHeap::endCall();
+
+    HOST_CHECK(HostHeap::printReport());
+
+    // the tracker sees allocations of the setup (HADevice's ID, registries, triggers)
+    HOST_CHECK(HostHeap::getAllocationsNb() > 0);
+    HOST_CHECK_EQUAL(0, HostHeap::getLiveBytes());
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,253 @@
+#include <ArduinoHA.h>
+
+#include "HostBroker.h"
+#include "HostClock.h"
+#include "HostNode.h"
+#include "HostTest.h"
+
+// Runs devices against the in-process broker: wildcards, retained messages,
+// commands routed between clients, last will and persistent sessions
+// (including a session left by the previous firmware).
+
+static uint32_t relayCommandsNb = 0;
+
+static void onRelayStateChanged(bool state, HASwitch* sender)
+{
+    (void)state;
+    (void)sender;
+
+    relayCommandsNb++;
+}
+
+static void runFor(HostNode& a, HostNode& b, HostBroker& broker, uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i += 10) {
+        a.mqtt.loop();
+        b.mqtt.loop();
+        broker.loop();
+        HostClock::advance(10);
+    }
+}
+
+/**
+ * Connects the node with a persistent session and loops until the discovery is completed.
+ */
+static bool connectPersistent(HostNode& node)
+{
+    node.mqtt.begin(IPAddress(127, 0, 0, 1), 1883, nullptr, nullptr, true);
+
+    for (uint32_t i = 0; i < 10000 && !node.mqtt.isDiscoveryCompleted(); i++) {
+        node.mqtt.loop();
+        HostClock::advance(1);
+    }
+
+    return node.mqtt.isDiscoveryCompleted();
+}
+
+static void testMatching()
+{
+    HOST_CHECK(HostBroker::matches("a/b/c", "a/b/c"));
+    HOST_CHECK(!HostBroker::matches("a/b/c", "a/b"));
+    HOST_CHECK(!HostBroker::matches("a/b", "a/b/c"));
+    HOST_CHECK(HostBroker::matches("a/+/c", "a/b/c"));
+    HOST_CHECK(HostBroker::matches("a/+/c", "a//c"));
+    HOST_CHECK(!HostBroker::matches("a/+/c", "a/b/d"));
+    HOST_CHECK(!HostBroker::matches("a/+", "a/b/c"));
+    HOST_CHECK(HostBroker::matches("+/+", "a/b"));
+    HOST_CHECK(HostBroker::matches("a/#", "a/b/c"));
+    HOST_CHECK(HostBroker::matches("a/#", "a"));
+    HOST_CHECK(HostBroker::matches("#", "a/b"));
+    HOST_CHECK(!HostBroker::matches("#", "$SYS/uptime"));
+    HOST_CHECK(!HostBroker::matches("+/uptime", "$SYS/uptime"));
+    HOST_CHECK(HostBroker::matches("$SYS/#", "$SYS/uptime"));
+}
+
+static void testRetained()
+{
+    HostBroker broker;
+    broker.publish("a/b", "1", 0, true);
+    broker.publish("a/c", "2", 1, true);
+    broker.publish("a/d", "3");
+    HOST_CHECK_EQUAL(2, broker.getRetainedNb());
+
+    std::vector<HostMessage> received;
+    broker.subscribe("a/+", [&received](const HostMessage& message) {
+        received.push_back(message);
+    });
+
+    HOST_CHECK_EQUAL(2, received.size());
+    HOST_CHECK(received.size() == 2 && received[0].retained && received[1].retained);
+
+    // established subscriptions get messages without the retain flag
+    broker.publish("a/b", "4", 0, true);
+    HOST_CHECK_EQUAL(3, received.size());
+    HOST_CHECK(received.size() == 3 && !received[2].retained && received[2].payload == "4");
+    HOST_CHECK(broker.getRetained("a/b") != nullptr && broker.getRetained("a/b")->payload == "4");
+
+    // empty payload removes the retained message
+    broker.publish("a/b", "", 0, true);
+    HOST_CHECK(broker.getRetained("a/b") == nullptr);
+    HOST_CHECK_EQUAL(1, broker.getRetainedNb());
+}
+
+int main()
+{
+    testMatching();
+    testRetained();
+
+    HostBroker broker;
+    std::vector<HostMessage> states;
+    broker.subscribe("homeassistant/switch/+/relay/state", [&states](const HostMessage& message) {
+        states.push_back(message);
+    });
+
+    HostNode a("device_a");
+    HostNode b("device_b");
+    a.client.setPeer(&broker);
+    b.client.setPeer(&broker);
+
+    a.device.enableSharedAvailability();
+    a.device.enableLastWill();
+    b.mqtt.setWildcardSubscription(true);
+
+    HASwitch* relayA = a.add(new HASwitch("relay", false, a.mqtt));
+    HASwitch* relayB = b.add(new HASwitch("relay", false, b.mqtt));
+    relayA->onStateChanged(onRelayStateChanged);
+    relayB->onStateChanged(onRelayStateChanged);
+
+    HOST_CHECK(a.connect());
+    HOST_CHECK(b.connect());
+    HOST_CHECK_EQUAL(2, broker.getConnectedNb());
+
+    // discovery is retained
+    HOST_CHECK(broker.getRetained("homeassistant/switch/device_a/relay/config") != nullptr);
+    HOST_CHECK(broker.getRetained("homeassistant/switch/device_b/relay/config") != nullptr);
+    const HostMessage* availability = broker.getRetained("homeassistant/device_a/avail");
+    HOST_CHECK(availability != nullptr && availability->payload == "online");
+
+    // initial states were published by both devices
+    HOST_CHECK_EQUAL(2, states.size());
+
+    // commands are routed to the right device (b uses the wildcard subscription)
+    states.clear();
+    broker.publish("homeassistant/switch/device_b/relay/cmd", "ON");
+    a.pump();
+    b.pump();
+    HOST_CHECK(!relayA->getState());
+    HOST_CHECK(relayB->getState());
+    HOST_CHECK_EQUAL(1, relayCommandsNb);
+    HOST_CHECK_EQUAL(1, states.size());
+    HOST_CHECK(
+        states.size() == 1 &&
+        states[0].topic == "homeassistant/switch/device_b/relay/state" &&
+        states[0].payload == "ON"
+    );
+
+    broker.publish("homeassistant/switch/device_a/relay/cmd", "ON");
+    a.pump();
+    b.pump();
+    HOST_CHECK(relayA->getState());
+    HOST_CHECK_EQUAL(2, relayCommandsNb);
+
+    // keepalive is maintained by the devices
+    runFor(a, b, broker, 120000);
+    HOST_CHECK_EQUAL(2, broker.getConnectedNb());
+    HOST_CHECK(broker.getPacketsNb(HostPacket::TypePingReq) > 0);
+
+    // lost link is detected by the broker once the keep alive expires
+    a.client.drop();
+    a.client.setRefusingConnections(true);
+    for (uint32_t i = 0; i < 30000; i += 10) {
+        b.mqtt.loop();
+        broker.loop();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK_EQUAL(1, broker.getConnectedNb());
+    availability = broker.getRetained("homeassistant/device_a/avail");
+    HOST_CHECK(availability != nullptr && availability->payload == "offline");
+
+    // the device comes back and overwrites its will
+    a.client.setRefusingConnections(false);
+    runFor(a, b, broker, 30000);
+    HOST_CHECK_EQUAL(2, broker.getConnectedNb());
+    availability = broker.getRetained("homeassistant/device_a/avail");
+    HOST_CHECK(availability != nullptr && availability->payload == "online");
+
+    // persistent session keeps QoS 1 messages of the disconnected client
+    HostNode c("device_c");
+    c.client.setPeer(&broker);
+    HASwitch* relayC = c.add(new HASwitch("relay", false, c.mqtt));
+    HOST_CHECK(connectPersistent(c));
+
+    c.client.drop();
+    c.client.setRefusingConnections(true);
+    broker.publish("homeassistant/switch/device_c/relay/cmd", "ON", 1);
+    HOST_CHECK(!relayC->getState());
+
+    c.client.setRefusingConnections(false);
+    for (uint32_t i = 0; i < 30000 && !relayC->getState(); i += 10) {
+        c.mqtt.loop();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK(relayC->getState());
+    HOST_CHECK(c.mqtt.isConnected());
+
+    // the session of the previous firmware doesn't cover entities added by the update
+    {
+        HostNode previous("device_d");
+        previous.client.setPeer(&broker);
+        previous.add(new HASwitch("relay1", false, previous.mqtt));
+        HOST_CHECK(connectPersistent(previous));
+        previous.client.stop(); // reboot
+    }
+
+    HostNode d("device_d");
+    d.client.setPeer(&broker);
+    d.add(new HASwitch("relay1", false, d.mqtt));
+    HASwitch* relay2 = d.add(new HASwitch("relay2", false, d.mqtt));
+
+    uint32_t subscribesNb = broker.getPacketsNb(HostPacket::TypeSubscribe);
+    HOST_CHECK(connectPersistent(d));
+    HOST_CHECK(broker.getPacketsNb(HostPacket::TypeSubscribe) > subscribesNb);
+
+    broker.publish("homeassistant/switch/device_d/relay2/cmd", "ON", 1);
+    d.pump();
+    HOST_CHECK(relay2->getState());
+
+    // Home Assistant's status is subscribed as well
+    uint32_t configsNb = 0;
+    broker.subscribe("homeassistant/switch/device_d/+/config", [&configsNb](const HostMessage& message) {
+        (void)message;
+
+        configsNb++;
+    });
+
+    configsNb = 0;
+    broker.publish("homeassistant/status", "online");
+    for (uint32_t i = 0; i < 10000 && configsNb < 2; i += 10) {
+        d.mqtt.loop();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK_EQUAL(2, configsNb);
+
+    // reconnect within the same boot relies on the session
+    d.client.stop();
+    subscribesNb = broker.getPacketsNb(HostPacket::TypeSubscribe);
+
+    for (uint32_t i = 0; i < 30000 && !d.mqtt.isDiscoveryCompleted(); i += 10) {
+        d.mqtt.loop();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK(d.mqtt.isDiscoveryCompleted());
+    HOST_CHECK_EQUAL(subscribesNb, broker.getPacketsNb(HostPacket::TypeSubscribe));
+
+    broker.publish("homeassistant/switch/device_d/relay2/cmd", "OFF", 1);
+    d.pump();
+    HOST_CHECK(!relay2->getState());
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,92 @@
+#include <string>
+#include <vector>
+
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostNode.h"
+#include "HostTest.h"
+
+// Deferred states that can't be published by the flush (the in-flight table
+// and the queue are full) stay dirty and are published by one of the next flushes,
+// even if the same value is set again in the meantime.
+
+static const char* TemperatureTopic = "homeassistant/sensor/host_node/temperature/state";
+
+static std::vector<std::string> findPayloads(
+    const HostResponder& responder,
+    const std::string& topic
+)
+{
+    std::vector<std::string> payloads;
+    const std::vector<HostMessage>& messages = responder.getMessages();
+
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (messages[i].topic == topic) {
+            payloads.push_back(messages[i].payload);
+        }
+    }
+
+    return payloads;
+}
+
+int main()
+{
+    HostNode node;
+    std::vector<HASwitch*> relays;
+
+    // each relay occupies the in-flight slot or the queue
+    for (uint32_t i = 0; i < ARDUINOHA_INFLIGHT_SIZE + ARDUINOHA_PUBLISH_QUEUE_SIZE; i++) {
+        relays.push_back(node.add(new HASwitch(node.name("relay", i), false, node.mqtt)));
+    }
+
+    HASensor<int32_t>* temperature = node.add(
+        new HASensor<int32_t>("temperature", 0, node.mqtt)
+    );
+
+    HOST_CHECK(node.connect());
+
+    node.mqtt.setDeferredPublishing(true);
+    node.mqtt.setPublishQoS(1);
+    node.mqtt.setRetransmitTimeout(1000);
+    node.responder.setRecording(true);
+    node.responder.setAcknowledging(false);
+
+    for (size_t i = 0; i < relays.size(); i++) {
+        HOST_CHECK(relays[i]->setState(true));
+    }
+
+    HOST_CHECK(temperature->setValue(21));
+
+    uint32_t failedPublishesNb = node.mqtt.getFailedPublishesNb();
+    node.mqtt.loop();
+
+    HOST_CHECK_EQUAL(ARDUINOHA_INFLIGHT_SIZE, node.mqtt.getInFlightNb());
+    HOST_CHECK(node.mqtt.getFailedPublishesNb() > failedPublishesNb);
+    HOST_CHECK(findPayloads(node.responder, TemperatureTopic).empty());
+
+    // the value is still dirty, so setting it again doesn't lose it;
+    // the messages in flight are acknowledged once they're retransmitted
+    HOST_CHECK(temperature->setValue(21));
+
+    node.responder.setAcknowledging(true);
+    for (int i = 0; i < 300 && node.mqtt.getInFlightNb() > 0; i++) {
+        node.mqtt.loop();
+        node.pump();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK_EQUAL(0, node.mqtt.getInFlightNb());
+
+    const std::vector<std::string> payloads = findPayloads(node.responder, TemperatureTopic);
+    HOST_CHECK_EQUAL(1, payloads.size());
+    HOST_CHECK(!payloads.empty() && payloads.back() == "21");
+
+    // nothing is left for the next flush
+    node.responder.clearMessages();
+    node.mqtt.loop();
+    node.pump();
+    HOST_CHECK(findPayloads(node.responder, TemperatureTopic).empty());
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,105 @@
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostNode.h"
+#include "HostTest.h"
+
+// Runs the whole lifecycle of the library against the harness:
+// connect, discovery, states, commands, QoS 1 and keepalive.
+
+static bool lastCommand = false;
+static int commandsNb = 0;
+
+static void onSwitchCommand(bool state, HASwitch* sender)
+{
+    (void)sender;
+
+    lastCommand = state;
+    commandsNb++;
+}
+
+static const HostMessage* findMessage(const HostResponder& responder, const std::string& topic)
+{
+    const std::vector<HostMessage>& messages = responder.getMessages();
+    for (size_t i = messages.size(); i > 0; i--) {
+        if (messages[i - 1].topic == topic) {
+            return &messages[i - 1];
+        }
+    }
+
+    return nullptr;
+}
+
+int main()
+{
+    HostNode node("harness");
+    node.responder.setRecording(true);
+
+    HASensor<int32_t>* sensor = node.add(new HASensor<int32_t>("temp", 0, node.mqtt));
+    HASwitch* sw = node.add(new HASwitch("relay", false, node.mqtt));
+    sw->onStateChanged(onSwitchCommand);
+
+    HOST_CHECK(node.connect());
+    HOST_CHECK_EQUAL(1, node.client.getConnectsNb());
+    HOST_CHECK_EQUAL(1, node.responder.getPacketsNb(HostPacket::TypeConnect));
+    HOST_CHECK(node.responder.getPacketsNb(HostPacket::TypeSubscribe) > 0);
+    HOST_CHECK(findMessage(node.responder, "homeassistant/sensor/harness/temp/config") != nullptr);
+    HOST_CHECK(findMessage(node.responder, "homeassistant/switch/harness/relay/config") != nullptr);
+
+    // state
+    node.responder.clearMessages();
+    HOST_CHECK(sensor->setValue(21));
+    const HostMessage* state = findMessage(node.responder, "homeassistant/sensor/harness/temp/state");
+    HOST_CHECK(state != nullptr);
+    HOST_CHECK(state != nullptr && state->payload == "21");
+
+    // command and the state's echo
+    node.responder.clearMessages();
+    node.responder.publish("homeassistant/switch/harness/relay/cmd", "ON");
+    node.pump();
+    HOST_CHECK_EQUAL(1, commandsNb);
+    HOST_CHECK(lastCommand);
+    state = findMessage(node.responder, "homeassistant/switch/harness/relay/state");
+    HOST_CHECK(state != nullptr && state->payload == "ON");
+
+    // QoS 1
+    node.mqtt.setPublishQoS(1);
+    node.responder.clearMessages();
+    HOST_CHECK(sensor->setValue(22));
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    HOST_CHECK_EQUAL(1, node.mqtt.getInFlightNb());
+    node.pump();
+    node.mqtt.loop();
+    HOST_CHECK_EQUAL(0, node.mqtt.getInFlightNb());
+    state = findMessage(node.responder, "homeassistant/sensor/harness/temp/state");
+    HOST_CHECK(state != nullptr && state->qos == 1);
+#else
+    // the in-flight table is disabled, so the message is published with QoS 0
+    HOST_CHECK_EQUAL(0, node.mqtt.getInFlightNb());
+    state = findMessage(node.responder, "homeassistant/sensor/harness/temp/state");
+    HOST_CHECK(state != nullptr && state->qos == 0 && state->payload == "22");
+#endif
+
+    // keepalive is driven by the virtual clock
+    const uint32_t pingsNb = node.responder.getPacketsNb(HostPacket::TypePingReq);
+    for (int i = 0; i < 60; i++) {
+        HostClock::advance(1000);
+        node.mqtt.loop();
+        node.pump();
+    }
+
+    HOST_CHECK(node.responder.getPacketsNb(HostPacket::TypePingReq) >= pingsNb + 3);
+    HOST_CHECK(node.mqtt.isConnected());
+
+    // lost connection is restored
+    node.client.drop();
+    for (int i = 0; i < 5000 && (node.client.getConnectsNb() < 2 || !node.mqtt.isDiscoveryCompleted()); i++) {
+        node.mqtt.loop();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK(node.mqtt.isConnected());
+    HOST_CHECK_EQUAL(2, node.client.getConnectsNb());
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,46 @@
+#include <ArduinoHA.h>
+
+#include "HostNode.h"
+#include "HostTest.h"
+
+// Commands with topics of 64 characters and longer reach their switch with both
+// backends. The built-in client sizes the topic's buffer from the longest
+// subscribed topic, messages with longer topics are dropped and counted.
+
+static const char* CommandTopic =
+    "homeassistant/switch/0123456789ab/living_room_ceiling_light_2/cmd";
+static const char* UnknownTopic =
+    "homeassistant/switch/0123456789ab/living_room_ceiling_light_with_dimmer_2/cmd";
+
+int main()
+{
+    HOST_CHECK(strlen(CommandTopic) >= 64);
+
+    HostNode node("0123456789ab");
+    HASwitch* light = node.add(new HASwitch("living_room_ceiling_light_2", false, node.mqtt));
+    HASwitch* relay = node.add(new HASwitch("relay", false, node.mqtt));
+
+    HOST_CHECK(node.connect());
+
+    node.responder.publish(CommandTopic, "ON");
+    node.pump();
+    HOST_CHECK(light->getState());
+    HOST_CHECK(!relay->getState());
+    HOST_CHECK_EQUAL(0, node.mqtt.getDroppedMessagesNb());
+
+    // the topic doesn't match any subscription
+    node.responder.publish(UnknownTopic, "OFF");
+    node.pump();
+    HOST_CHECK(light->getState());
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    HOST_CHECK_EQUAL(1, node.mqtt.getDroppedMessagesNb());
+#endif
+
+    // messages after the dropped one are still received
+    node.responder.publish(CommandTopic, "OFF");
+    node.pump();
+    HOST_CHECK(!light->getState());
+
+    return HOST_TEST_RESULT();
+}
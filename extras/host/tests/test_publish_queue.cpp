@@ -0,0 +1,89 @@
+#include <string>
+#include <vector>
+
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostNode.h"
+#include "HostTest.h"
+
+// Messages published while the device is offline are queued and published
+// in order once the discovery is completed. Messages published during
+// the reconnect must not overtake the queued ones, even if the queue is full.
+
+static const char* EventTopic = "aha/events";
+
+static std::vector<std::string> findEvents(const HostResponder& responder)
+{
+    std::vector<std::string> events;
+    const std::vector<HostMessage>& messages = responder.getMessages();
+
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (messages[i].topic == EventTopic) {
+            events.push_back(messages[i].payload);
+        }
+    }
+
+    return events;
+}
+
+int main()
+{
+    HostNode node;
+    for (uint32_t i = 0; i < 3; i++) {
+        node.add(new HASwitch(node.name("relay", i), false, node.mqtt));
+    }
+
+    HOST_CHECK(node.connect());
+
+    // offline: the queue is filled with events
+    node.client.drop();
+    node.client.setRefusingConnections(true);
+    node.mqtt.loop();
+    HOST_CHECK(!node.mqtt.isConnected());
+
+    std::vector<std::string> queued;
+    for (uint32_t i = 0; i < ARDUINOHA_PUBLISH_QUEUE_SIZE; i++) {
+        queued.push_back(std::to_string(i));
+        HOST_CHECK(node.mqtt.publish(EventTopic, queued.back().c_str()));
+    }
+
+    uint32_t failedPublishesNb = node.mqtt.getFailedPublishesNb();
+    HOST_CHECK(!node.mqtt.publish(EventTopic, "overflow"));
+    HOST_CHECK_EQUAL(failedPublishesNb + 1, node.mqtt.getFailedPublishesNb());
+
+    // reconnect: the queue is published once the discovery is completed
+    node.client.setRefusingConnections(false);
+    node.responder.setRecording(true);
+    node.responder.clearMessages();
+
+    for (uint32_t i = 0; i < 100000 &&
+            node.mqtt.getConnectionState() != HAMqtt::StateAnnouncing; i++) {
+        node.mqtt.loop();
+        HostClock::advance(1);
+    }
+
+    HOST_CHECK(node.mqtt.getConnectionState() == HAMqtt::StateAnnouncing);
+    HOST_CHECK(node.mqtt.isConnected());
+
+    failedPublishesNb = node.mqtt.getFailedPublishesNb();
+    HOST_CHECK(!node.mqtt.publish(EventTopic, "announcing"));
+    HOST_CHECK_EQUAL(failedPublishesNb + 1, node.mqtt.getFailedPublishesNb());
+    HOST_CHECK(findEvents(node.responder).empty());
+
+    for (uint32_t i = 0; i < 1000 && !node.mqtt.isDiscoveryCompleted(); i++) {
+        node.mqtt.loop();
+        HostClock::advance(1);
+    }
+
+    node.mqtt.loop();
+    HOST_CHECK(node.mqtt.isDiscoveryCompleted());
+    HOST_CHECK(findEvents(node.responder) == queued);
+
+    // the queue is empty, so messages are published right away
+    HOST_CHECK(node.mqtt.publish(EventTopic, "connected"));
+    queued.push_back("connected");
+    HOST_CHECK(findEvents(node.responder) == queued);
+
+    return HOST_TEST_RESULT();
+}
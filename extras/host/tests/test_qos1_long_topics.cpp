@@ -0,0 +1,100 @@
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostNode.h"
+#include "HostTest.h"
+
+// QoS 1 messages with topics longer than 64 characters occupy the in-flight
+// slot and are retransmitted until they're acknowledged. Messages that don't fit
+// the slot (ARDUINOHA_INFLIGHT_TOPIC_SIZE) are published with QoS 0 instead of being lost.
+
+static const char* DoorTopic = "homeassistant/binary_sensor/0123456789ab/front_door_contact_sensor/state";
+static const char* WindowTopic =
+    "homeassistant/binary_sensor/0123456789ab/"
+    "living_room_window_contact_sensor_with_a_really_long_name/state";
+
+static const HostMessage* findMessage(const HostResponder& responder, const std::string& topic)
+{
+    const std::vector<HostMessage>& messages = responder.getMessages();
+    for (size_t i = messages.size(); i > 0; i--) {
+        if (messages[i - 1].topic == topic) {
+            return &messages[i - 1];
+        }
+    }
+
+    return nullptr;
+}
+
+static uint32_t countMessages(const HostResponder& responder, const std::string& topic)
+{
+    uint32_t count = 0;
+    const std::vector<HostMessage>& messages = responder.getMessages();
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (messages[i].topic == topic) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+int main()
+{
+    HOST_CHECK(strlen(DoorTopic) > 64);
+    HOST_CHECK(strlen(DoorTopic) < ARDUINOHA_INFLIGHT_TOPIC_SIZE);
+    HOST_CHECK(strlen(WindowTopic) >= ARDUINOHA_INFLIGHT_TOPIC_SIZE);
+
+    HostNode node("0123456789ab");
+    HABinarySensor* door = node.add(new HABinarySensor(
+        "front_door_contact_sensor",
+        false,
+        node.mqtt
+    ));
+    HABinarySensor* window = node.add(new HABinarySensor(
+        "living_room_window_contact_sensor_with_a_really_long_name",
+        false,
+        node.mqtt
+    ));
+
+    HOST_CHECK(node.connect());
+
+    node.mqtt.setPublishQoS(1);
+    node.mqtt.setRetransmitTimeout(1000);
+    node.responder.setRecording(true);
+    node.responder.setAcknowledging(false);
+
+    // the long topic fits the in-flight slot
+    HOST_CHECK(door->setState(true));
+    HOST_CHECK_EQUAL(1, node.mqtt.getInFlightNb());
+    const HostMessage* message = findMessage(node.responder, DoorTopic);
+    HOST_CHECK(message != nullptr && message->qos == 1 && message->payload == "ON");
+
+    // and it's retransmitted until the broker acknowledges it
+    for (int i = 0; i < 150; i++) {
+        node.mqtt.loop();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK(node.mqtt.getRetransmitsNb() > 0);
+    HOST_CHECK(countMessages(node.responder, DoorTopic) > 1);
+    message = findMessage(node.responder, DoorTopic);
+    HOST_CHECK(message != nullptr && message->qos == 1 && message->payload == "ON");
+
+    node.responder.setAcknowledging(true);
+    for (int i = 0; i < 300 && node.mqtt.getInFlightNb() > 0; i++) {
+        node.mqtt.loop();
+        node.pump();
+        HostClock::advance(10);
+    }
+
+    HOST_CHECK_EQUAL(0, node.mqtt.getInFlightNb());
+
+    // the topic that doesn't fit the slot is published with QoS 0
+    node.responder.clearMessages();
+    HOST_CHECK(window->setState(true));
+    HOST_CHECK_EQUAL(0, node.mqtt.getInFlightNb());
+    message = findMessage(node.responder, WindowTopic);
+    HOST_CHECK(message != nullptr && message->qos == 0 && message->payload == "ON");
+
+    return HOST_TEST_RESULT();
+}
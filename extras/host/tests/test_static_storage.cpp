@@ -0,0 +1,98 @@
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostHeap.h"
+#include "HostResponder.h"
+#include "HostTest.h"
+
+// HAMqttStatic and HATriggersStatic (with HADevice that has a string ID)
+// must not allocate anything during construction, connection and an hour
+// of steady state including a reconnect. Devices types and triggers
+// above the capacity are rejected instead.
+//
+// PubSubClient allocates its own packet buffer in its constructor,
+// that's outside of the library's allocation macros, so it's not counted here.
+
+static const uint32_t SteadyStateDuration = 3600; // seconds
+
+static bool hasMessage(const HostResponder& responder, const std::string& topic)
+{
+    const std::vector<HostMessage>& messages = responder.getMessages();
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (messages[i].topic == topic) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main()
+{
+    HostResponder responder;
+    HostClient client(responder);
+    responder.setRecording(true);
+
+    // construction
+    HADevice device("static_device");
+    device.enableSharedAvailability();
+    device.enableLastWill();
+
+    HAMqttStatic<4> mqtt(client, device);
+    HASensor<int32_t> sensor("temperature", 0, mqtt);
+    HASwitch relay("relay", false, mqtt);
+    HABinarySensor door("door", false, mqtt);
+    HATriggersStatic<2> triggers(mqtt);
+    HABinarySensor window("window", false, mqtt); // above the capacity
+
+    HOST_CHECK(triggers.add("button_short_press", "button_1"));
+    HOST_CHECK(triggers.add("button_long_press", "button_1"));
+    HOST_CHECK(!triggers.add("button_double_press", "button_1"));
+    HOST_CHECK_EQUAL(0, HostHeap::getAllocationsNb());
+
+    // connection
+    mqtt.begin(IPAddress(127, 0, 0, 1));
+    for (int i = 0; i < 10000 && !mqtt.isDiscoveryCompleted(); i++) {
+        mqtt.loop();
+        HostClock::advance(1);
+    }
+
+    HOST_CHECK(mqtt.isDiscoveryCompleted());
+    HOST_CHECK(hasMessage(responder, "homeassistant/switch/static_device/relay/config"));
+    HOST_CHECK(hasMessage(responder, "homeassistant/binary_sensor/static_device/door/config"));
+    HOST_CHECK(!hasMessage(responder, "homeassistant/binary_sensor/static_device/window/config"));
+    HOST_CHECK_EQUAL(0, HostHeap::getAllocationsNb());
+
+    // steady state
+    responder.setRecording(false);
+    for (uint32_t second = 0; second < SteadyStateDuration; second += 10) {
+        for (uint32_t ms = 0; ms < 10000; ms += 10) {
+            mqtt.loop();
+            HostClock::advance(10);
+        }
+
+        sensor.setValue(second);
+        door.setState(second % 20 == 0);
+        triggers.trigger("button_short_press", "button_1");
+
+        if (mqtt.isConnected()) {
+            responder.publish("homeassistant/switch/static_device/relay/cmd", (second % 20 == 0 ? "ON" : "OFF"));
+            while (client.available() > 0) {
+                mqtt.loop();
+            }
+
+            HOST_CHECK(relay.getState() == (second % 20 == 0));
+        }
+
+        if (second == SteadyStateDuration / 2) {
+            client.drop();
+        }
+    }
+
+    HOST_CHECK(mqtt.isConnected());
+    HOST_CHECK_EQUAL(2, client.getConnectsNb());
+    HOST_CHECK_EQUAL(0, HostHeap::getAllocationsNb());
+    HOST_CHECK_EQUAL(0, HostHeap::getPeakBytes());
+
+    return HOST_TEST_RESULT();
+}
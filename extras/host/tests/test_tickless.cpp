@@ -0,0 +1,124 @@
+#include <stdio.h>
+
+#include <ArduinoHA.h>
+
+#include "HostClock.h"
+#include "HostNode.h"
+#include "HostTest.h"
+
+// Runs a tickless loop on the virtual clock: the node sleeps for
+// HAMqtt::nextWakeupIn and wakes up early only on network activity.
+// A sketch with a 60 s sampling task, a rate-limited sensor with heartbeat
+// and diagnostics must need at most a few hundred wakeups per hour,
+// both while connected and while the broker is unreachable.
+// The heartbeat of a sensor whose state can't be queued (the topic doesn't fit
+// ARDUINOHA_QUEUE_TOPIC_SIZE) mustn't keep the node awake while offline.
+
+static const uint32_t Hour = 3600000; // ms
+static const uint32_t MaxSpinningLoopsNb = 100;
+
+static HASensor<int32_t>* sensor = nullptr;
+static uint32_t samplesNb = 0;
+
+static void sample(void* context)
+{
+    (void)context;
+
+    samplesNb++;
+    sensor->setValue(samplesNb);
+}
+
+/**
+ * Runs the loop for the given time and returns number of wakeups.
+ * Returns UINT32_MAX if the library asks for loops without any progress.
+ */
+static uint32_t runTickless(HostNode& node, uint32_t duration)
+{
+    const uint64_t endsAt = HostClock::now() + (uint64_t)duration * 1000;
+    uint32_t wakeupsNb = 0;
+    uint32_t spinningLoopsNb = 0;
+
+    while (HostClock::now() < endsAt) {
+        uint32_t wakeupIn = node.mqtt.nextWakeupIn();
+
+        // received data wakes up the node right away
+        if (wakeupIn > 0 && node.client.available() == 0) {
+            const uint64_t left = (endsAt - HostClock::now()) / 1000;
+            if (wakeupIn > left) {
+                HostClock::set(endsAt);
+                break;
+            }
+
+            HostClock::advance(wakeupIn);
+            spinningLoopsNb = 0;
+        } else if (++spinningLoopsNb > MaxSpinningLoopsNb) {
+            return UINT32_MAX;
+        }
+
+        node.mqtt.loop();
+        wakeupsNb++;
+    }
+
+    return wakeupsNb;
+}
+
+int main()
+{
+    HostNode node;
+    sensor = node.add(new HASensor<int32_t>("sample", 0, node.mqtt));
+    sensor->setMinPublishInterval(10000);
+    sensor->setMaxPublishInterval(300000);
+    node.add(new HADiagnostics(node.mqtt));
+
+    HASensor<int32_t>* unqueueable = node.add(new HASensor<int32_t>(
+        "outdoor_temperature_sensor_2",
+        0,
+        node.mqtt
+    ));
+    unqueueable->setMinPublishInterval(10000);
+    unqueueable->setMaxPublishInterval(300000);
+
+    HOST_CHECK(node.connect());
+    HOST_CHECK(node.mqtt.schedule(sample, 60000, 60000));
+
+    // connected
+    const uint32_t pingsNb = node.responder.getPacketsNb(HostPacket::TypePingReq);
+    const uint32_t connectedWakeupsNb = runTickless(node, Hour);
+    const uint32_t connectedPingsNb = node.responder.getPacketsNb(HostPacket::TypePingReq) - pingsNb;
+
+    printf("connected: %u wakeups per hour, %u pings\n", connectedWakeupsNb, connectedPingsNb);
+    HOST_CHECK(connectedWakeupsNb != UINT32_MAX);
+    HOST_CHECK(connectedWakeupsNb <= 1000);
+    HOST_CHECK(node.mqtt.isConnected());
+    HOST_CHECK_EQUAL(60, samplesNb);
+
+    // the keepalive is maintained while sleeping (15 s)
+    HOST_CHECK(connectedPingsNb >= 200);
+
+    // broker is unreachable
+    node.client.setRefusingConnections(true);
+    node.client.drop();
+    samplesNb = 0;
+
+    const uint32_t connectsNb = node.client.getConnectsNb();
+    const uint32_t failedPublishesNb = node.mqtt.getFailedPublishesNb();
+    const uint32_t offlineWakeupsNb = runTickless(node, Hour);
+    const uint32_t attemptsNb = node.client.getConnectsNb() - connectsNb;
+
+    printf("offline: %u wakeups per hour, %u connection attempts\n", offlineWakeupsNb, attemptsNb);
+    HOST_CHECK(offlineWakeupsNb != UINT32_MAX);
+    HOST_CHECK(offlineWakeupsNb <= 200);
+    HOST_CHECK(!node.mqtt.isConnected());
+    HOST_CHECK(attemptsNb > 0 && attemptsNb <= 100);
+    HOST_CHECK_EQUAL(60, samplesNb);
+
+    // the heartbeat isn't retried while offline
+    HOST_CHECK_EQUAL(failedPublishesNb, node.mqtt.getFailedPublishesNb());
+
+    // the node reconnects once the broker is back
+    node.client.setRefusingConnections(false);
+    runTickless(node, 120000);
+    HOST_CHECK(node.mqtt.isConnected());
+
+    return HOST_TEST_RESULT();
+}
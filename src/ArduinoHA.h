@@ -2,7 +2,9 @@
 #define AHA_ARDUINOHA_H
 
 #include "HADevice.h"
+#include "HADiagnostics.h"
 #include "HAMqtt.h"
+#include "HAMqttStatic.h"
 #include "HAUtils.h"
 #include "device-types/HABinarySensor.h"
 #include "device-types/HASensor.h"
@@ -1,4 +1,120 @@
+#ifndef AHA_ARDUINOHADEFINES_H
+#define AHA_ARDUINOHADEFINES_H
+
 // Turns on debug information of the ArduinoHA core.
 // Please note that you need to initialize serial interface manually
 // by calling Serial.begin([baudRate]) before initializing ArduinoHA.
 // #define ARDUINOHA_DEBUG
+
+// Turns on latency statistics of the phases of HAMqtt::loop (see HALoopStats).
+// No code related to the statistics is compiled if it's not defined.
+// #define ARDUINOHA_LOOP_STATS
+
+// Replaces PubSubClient with the built-in MQTT client (see HAMqttClient).
+// The built-in client encodes outgoing messages straight to the network client,
+// connects without blocking the loop and parses incoming packets incrementally.
+// #define ARDUINOHA_NATIVE_MQTT
+
+// Maximum number of messages that can be queued while the connection with
+// the MQTT broker is not established. Retained messages (states) are coalesced
+// by topic, so only the latest state of the entity is kept in the queue.
+// Each slot of the queue occupies ARDUINOHA_QUEUE_TOPIC_SIZE + ARDUINOHA_QUEUE_PAYLOAD_SIZE
+// bytes of RAM. Set the value to 0 in order to disable the queue.
+#ifndef ARDUINOHA_PUBLISH_QUEUE_SIZE
+#define ARDUINOHA_PUBLISH_QUEUE_SIZE 2
+#endif
+
+// Maximum length of the queued message's topic (including null terminator).
+#ifndef ARDUINOHA_QUEUE_TOPIC_SIZE
+#define ARDUINOHA_QUEUE_TOPIC_SIZE 64
+#endif
+
+// Maximum length of the queued message's payload (including null terminator).
+#ifndef ARDUINOHA_QUEUE_PAYLOAD_SIZE
+#define ARDUINOHA_QUEUE_PAYLOAD_SIZE 24
+#endif
+
+// Size of the buffer that combines writes of a single MQTT message
+// (header, topic and payload chunks) into larger writes to the network client.
+// The buffer is flushed when it's full or at the end of the message.
+// Set the value to 0 in order to disable the buffer.
+#ifndef ARDUINOHA_WRITE_BUFFER_SIZE
+#define ARDUINOHA_WRITE_BUFFER_SIZE 64
+#endif
+
+// Maximum number of QoS 1 messages that wait for the broker's acknowledgement (PUBACK).
+// Each slot occupies ARDUINOHA_INFLIGHT_TOPIC_SIZE + ARDUINOHA_INFLIGHT_PAYLOAD_SIZE
+// bytes of RAM, so QoS 1 support is disabled by default. In order to enable it
+// define the value using build flags (e.g. -DARDUINOHA_INFLIGHT_SIZE=2) or change it here,
+// and call HAMqtt::setPublishQoS(1).
+#ifndef ARDUINOHA_INFLIGHT_SIZE
+#define ARDUINOHA_INFLIGHT_SIZE 0
+#endif
+
+// Maximum length of the in-flight message's topic (including null terminator).
+// Messages that don't fit the in-flight slot are published with QoS 0.
+#ifndef ARDUINOHA_INFLIGHT_TOPIC_SIZE
+#define ARDUINOHA_INFLIGHT_TOPIC_SIZE 96
+#endif
+
+// Maximum length of the in-flight message's payload (including null terminator).
+#ifndef ARDUINOHA_INFLIGHT_PAYLOAD_SIZE
+#define ARDUINOHA_INFLIGHT_PAYLOAD_SIZE 32
+#endif
+
+// Maximum number of devices types whose states can be deferred until HAMqtt::flush
+// (see HAMqtt::setDeferredPublishing). The dirty set occupies one bit per device type.
+// Devices types registered beyond the limit publish their states right away.
+// Set the value to 0 in order to disable deferred publishing.
+#ifndef ARDUINOHA_DIRTY_SET_SIZE
+#define ARDUINOHA_DIRTY_SET_SIZE 32
+#endif
+
+// Maximum number of tasks that can be scheduled using HAMqtt::schedule.
+// Each slot occupies 16 bytes of RAM (12 bytes on AVR).
+// Set the value to 0 in order to disable the scheduler.
+#ifndef ARDUINOHA_SCHEDULER_SIZE
+#define ARDUINOHA_SCHEDULER_SIZE 4
+#endif
+
+// Default size of the received topic's buffer embedded in HAMqttStatic (including null terminator).
+// Used only by the built-in MQTT client. HAMqtt sizes the buffer on the heap
+// from the longest subscribed topic, so this limit doesn't apply to it.
+#ifndef ARDUINOHA_RECEIVE_TOPIC_SIZE
+#define ARDUINOHA_RECEIVE_TOPIC_SIZE 64
+#endif
+
+// Maximum length of the received message's payload passed to BaseDeviceType::onMqttMessage.
+// Used only by the built-in MQTT client. Longer payloads are passed only to
+// the streaming handlers (see BaseDeviceType::onMqttMessageBegin).
+#ifndef ARDUINOHA_RECEIVE_PAYLOAD_SIZE
+#define ARDUINOHA_RECEIVE_PAYLOAD_SIZE 128
+#endif
+
+// Clock used by the library's timers (timeouts, intervals, budgets).
+// It can be redefined using build flags, e.g. in order to drive the library
+// by a virtual clock in tests. Latency statistics (ARDUINOHA_LOOP_STATS)
+// always measure the real time.
+#ifndef ARDUINOHA_MILLIS
+#define ARDUINOHA_MILLIS() millis()
+#endif
+
+#ifndef ARDUINOHA_MICROS
+#define ARDUINOHA_MICROS() micros()
+#endif
+
+// Functions used by the library to manage dynamic memory. They can be redefined
+// using build flags in order to track allocations of the library.
+#ifndef ARDUINOHA_MALLOC
+#define ARDUINOHA_MALLOC(size) malloc(size)
+#endif
+
+#ifndef ARDUINOHA_REALLOC
+#define ARDUINOHA_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+
+#ifndef ARDUINOHA_FREE
+#define ARDUINOHA_FREE(ptr) free(ptr)
+#endif
+
+#endif
@@ -1,35 +1,52 @@
 #include <Arduino.h>
 
 #include "HADevice.h"
+#include "ArduinoHADefines.h"
+#include "HAMqtt.h"
 #include "HAUtils.h"
+#include "device-types/DeviceTypeSerializer.h"
 
 #define HADEVICE_INIT \
     _manufacturer(nullptr), \
     _model(nullptr), \
     _name(nullptr), \
-    _softwareVersion(nullptr)
+    _softwareVersion(nullptr), \
+    _mqtt(nullptr), \
+    _sharedAvailability(false), \
+    _lastWill(false), \
+    _available(true)
 
 HADevice::HADevice() :
     _uniqueId(nullptr),
-    HADEVICE_INIT
+    HADEVICE_INIT,
+    _ownsUniqueId(false)
 {
 
 }
 
 HADevice::HADevice(const char* uniqueId) :
     _uniqueId(uniqueId),
-    HADEVICE_INIT
+    HADEVICE_INIT,
+    _ownsUniqueId(false)
 {
 
 }
 
 HADevice::HADevice(const byte* uniqueId, const uint16_t& length) :
     _uniqueId(HAUtils::byteArrayToStr(uniqueId, length)),
-    HADEVICE_INIT
+    HADEVICE_INIT,
+    _ownsUniqueId(true)
 {
 
 }
 
+HADevice::~HADevice()
+{
+    if (_ownsUniqueId) {
+        ARDUINOHA_FREE((void*)_uniqueId);
+    }
+}
+
 bool HADevice::setUniqueId(const byte* uniqueId, const uint16_t& length)
 {
     if (_uniqueId != nullptr) {
@@ -37,9 +54,41 @@ bool HADevice::setUniqueId(const byte* uniqueId, const uint16_t& length)
     }
 
     _uniqueId = HAUtils::byteArrayToStr(uniqueId, length);
+    _ownsUniqueId = true;
     return true;
 }
 
+void HADevice::setAvailability(bool online)
+{
+    _available = online;
+    publishAvailability();
+}
+
+void HADevice::publishAvailability()
+{
+    if (_mqtt == nullptr || !_sharedAvailability) {
+        return;
+    }
+
+    const uint16_t& topicSize = DeviceTypeSerializer::calculateDeviceAvailabilityTopicLength(_mqtt);
+    if (topicSize == 0) {
+        return;
+    }
+
+    char topic[topicSize];
+    DeviceTypeSerializer::generateDeviceAvailabilityTopic(_mqtt, topic);
+
+    _mqtt->publish(
+        topic,
+        (
+            _available ?
+            DeviceTypeSerializer::Online :
+            DeviceTypeSerializer::Offline
+        ),
+        true
+    );
+}
+
 uint16_t HADevice::calculateSerializedLength() const
 {
     uint16_t size =
@@ -3,12 +3,19 @@
 
 #include <Arduino.h>
 
+class HAMqtt;
+
 class HADevice
 {
 public:
     HADevice();
     HADevice(const char* uniqueId);
     HADevice(const byte* uniqueId, const uint16_t& length);
+    ~HADevice();
+
+    // the device owns the unique ID generated from bytes, so it can't be copied
+    HADevice(const HADevice&) = delete;
+    HADevice& operator=(const HADevice&) = delete;
 
     inline const char* getUniqueId() const
         { return _uniqueId; }
@@ -25,6 +32,44 @@ public:
     inline void setSoftwareVersion(const char* softwareVersion)
         { _softwareVersion = softwareVersion; }
 
+    /**
+     * Enables availability topic shared by all devices types of the device.
+     * Topic format: [discovery prefix]/[device ID]/avail
+     * Devices types with their own availability (see BaseDeviceType::setAvailability)
+     * still use their own topics.
+     */
+    inline void enableSharedAvailability()
+        { _sharedAvailability = true; }
+
+    /**
+     * Registers the shared availability topic as MQTT Last Will,
+     * so the broker marks the device as offline if the connection is broken.
+     * The method enables shared availability as well.
+     */
+    inline void enableLastWill()
+        { _sharedAvailability = true; _lastWill = true; }
+
+    inline bool isSharedAvailabilityEnabled() const
+        { return _sharedAvailability; }
+
+    inline bool isLastWillEnabled() const
+        { return _lastWill; }
+
+    inline bool isOnline() const
+        { return _available; }
+
+    /**
+     * Changes availability of the device and publishes it to the shared availability topic.
+     *
+     * @param online
+     */
+    void setAvailability(bool online);
+
+    /**
+     * Publishes current availability of the device (if shared availability is enabled).
+     */
+    void publishAvailability();
+
     bool setUniqueId(const byte* uniqueId, const uint16_t& length);
     uint16_t calculateSerializedLength() const;
     uint16_t serialize(char* dst) const;
@@ -35,6 +80,13 @@ private:
     const char* _model;
     const char* _name;
     const char* _softwareVersion;
+    HAMqtt* _mqtt;
+    bool _sharedAvailability;
+    bool _lastWill;
+    bool _available;
+    bool _ownsUniqueId;
+
+    friend class HAMqtt;
 };
 
 #endif
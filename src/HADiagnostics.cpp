@@ -0,0 +1,114 @@
+#include <Arduino.h>
+
+#include "HADiagnostics.h"
+#include "HAMqtt.h"
+#include "HAUtils.h"
+#include "device-types/HASensor.cpp"
+
+#if defined(ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+#if defined(__AVR__)
+extern char __heap_start;
+extern char* __brkval;
+
+static uint32_t getAvrFreeMemory()
+{
+    // gap between the top of the heap and the stack
+    char top;
+    return &top - (__brkval != nullptr ? __brkval : &__heap_start);
+}
+#endif
+
+static const char* ComponentName = "sensor";
+static const char* Name = "diagnostics";
+
+HADiagnostics::HADiagnostics(HAMqtt& mqtt) :
+    BaseDeviceType(mqtt, ComponentName, Name),
+    _interval(DefaultInterval),
+    _lastUpdateAt(0),
+    _lastPublishedNb(0),
+    _publishRate("diag_publish_rate", 0, mqtt),
+    _bytesSent("diag_bytes_sent", 0, mqtt),
+    _failedPublishes("diag_failed_publishes", 0, mqtt),
+    _reconnects("diag_reconnects", 0, mqtt),
+    _queueDepth("diag_queue_depth", 0, mqtt)
+#if defined(AHA_HEAP_DIAGNOSTICS)
+    , _freeHeap("diag_free_heap", 0, mqtt)
+    , _maxFreeBlock("diag_max_free_block", 0, mqtt)
+#endif
+#if defined(ARDUINOHA_LOOP_STATS)
+    , _worstLoopTime("diag_worst_loop_time", 0, mqtt)
+#endif
+{
+    _publishRate.setUnitOfMeasurement("msg/s");
+    _bytesSent.setUnitOfMeasurement("B");
+
+#if defined(AHA_HEAP_DIAGNOSTICS)
+    _freeHeap.setUnitOfMeasurement("B");
+    _maxFreeBlock.setUnitOfMeasurement("B");
+#endif
+
+#if defined(ARDUINOHA_LOOP_STATS)
+    _worstLoopTime.setUnitOfMeasurement("us");
+#endif
+}
+
+void HADiagnostics::onMqttLoop()
+{
+    if (!mqtt()->isConnected() ||
+            (ARDUINOHA_MILLIS() - _lastUpdateAt) < _interval) {
+        return;
+    }
+
+    updateMetrics();
+}
+
+uint32_t HADiagnostics::nextLoopIn() const
+{
+    // metrics aren't updated while the broker is disconnected
+    if (!mqtt()->isConnected()) {
+        return UINT32_MAX;
+    }
+
+    return HAUtils::timeLeft(_lastUpdateAt, _interval);
+}
+
+void HADiagnostics::updateMetrics()
+{
+    const uint32_t& elapsed = ARDUINOHA_MILLIS() - _lastUpdateAt;
+    const uint32_t& publishedNb = mqtt()->getPublishedNb();
+
+    _lastUpdateAt = ARDUINOHA_MILLIS();
+
+    if (elapsed > 0) {
+        _publishRate.setValue((publishedNb - _lastPublishedNb) * 1000.0f / elapsed);
+    }
+
+    _bytesSent.setValue(mqtt()->getBytesSent());
+    _failedPublishes.setValue(mqtt()->getFailedPublishesNb());
+    _reconnects.setValue(mqtt()->getReconnectsNb());
+    _queueDepth.setValue(mqtt()->getQueueSize());
+
+#if defined(ESP8266)
+    _freeHeap.setValue(ESP.getFreeHeap());
+    _maxFreeBlock.setValue(ESP.getMaxFreeBlockSize());
+#elif defined(ESP32)
+    _freeHeap.setValue(ESP.getFreeHeap());
+    _maxFreeBlock.setValue(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+#elif defined(__AVR__)
+    const uint32_t& freeMemory = getAvrFreeMemory();
+    _freeHeap.setValue(freeMemory);
+    _maxFreeBlock.setValue(freeMemory);
+#endif
+
+#if defined(ARDUINOHA_LOOP_STATS)
+    _worstLoopTime.setValue(
+        mqtt()->getLoopStats().get(HALoopStats::PhaseLoop).max
+    );
+#endif
+
+    // the diagnostics' own messages are excluded from the rate
+    _lastPublishedNb = mqtt()->getPublishedNb();
+}
@@ -0,0 +1,61 @@
+#ifndef AHA_HADIAGNOSTICS_H
+#define AHA_HADIAGNOSTICS_H
+
+#include "ArduinoHADefines.h"
+#include "device-types/BaseDeviceType.h"
+#include "device-types/HASensor.h"
+
+#if defined(ESP8266) || defined(ESP32) || defined(__AVR__)
+#define AHA_HEAP_DIAGNOSTICS
+#endif
+
+/**
+ * Set of sensors that report metrics of the library to Home Assistant:
+ * publish rate, bytes sent, failed publishes, reconnects, depth of the publish queue,
+ * free heap and the largest free block (ESP8266, ESP32 and AVR only),
+ * and the worst loop time (only if ARDUINOHA_LOOP_STATS is defined).
+ * The values are updated periodically from within HAMqtt::loop.
+ */
+class HADiagnostics : public BaseDeviceType
+{
+public:
+    static const uint32_t DefaultInterval = 60000; // ms
+
+    HADiagnostics(HAMqtt& mqtt);
+
+    /**
+     * Sets interval between two consecutive updates of the metrics.
+     *
+     * @param interval Interval in milliseconds.
+     */
+    inline void setInterval(uint32_t interval)
+        { _interval = interval; }
+
+protected:
+    virtual void onMqttConnected() override { };
+    virtual void onMqttLoop() override;
+    virtual uint32_t nextLoopIn() const override;
+
+private:
+    void updateMetrics();
+
+    uint32_t _interval;
+    uint32_t _lastUpdateAt;
+    uint32_t _lastPublishedNb;
+    HASensor<float> _publishRate;
+    HASensor<uint32_t> _bytesSent;
+    HASensor<uint32_t> _failedPublishes;
+    HASensor<uint32_t> _reconnects;
+    HASensor<uint8_t> _queueDepth;
+
+#if defined(AHA_HEAP_DIAGNOSTICS)
+    HASensor<uint32_t> _freeHeap;
+    HASensor<uint32_t> _maxFreeBlock;
+#endif
+
+#if defined(ARDUINOHA_LOOP_STATS)
+    HASensor<uint32_t> _worstLoopTime;
+#endif
+};
+
+#endif
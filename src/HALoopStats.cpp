@@ -0,0 +1,78 @@
+#include <Arduino.h>
+
+#include "HALoopStats.h"
+
+#if defined(ARDUINOHA_LOOP_STATS)
+
+#if !defined(ARDUINO)
+#include <time.h>
+#endif
+
+HALoopStats::Probe::Probe(HALoopStats& stats, Phase phase) :
+    _stats(stats),
+    _phase(phase),
+    _startedAt(HALoopStats::now())
+{
+
+}
+
+HALoopStats::Probe::~Probe()
+{
+    _stats.record(_phase, HALoopStats::now() - _startedAt);
+}
+
+HALoopStats::HALoopStats()
+{
+    reset();
+}
+
+void HALoopStats::record(Phase phase, uint32_t duration)
+{
+    PhaseStats& stats = _phases[phase];
+
+    if (stats.count == 0 || duration < stats.min) {
+        stats.min = duration;
+    }
+
+    if (duration > stats.max) {
+        stats.max = duration;
+    }
+
+    stats.count++;
+    stats.sum += duration;
+
+    // index of the bucket is the number of significant bits of the duration
+    uint8_t bucket = 0;
+    while (duration > 0 && bucket < (BucketsNb - 1)) {
+        duration >>= 1;
+        bucket++;
+    }
+
+    if (stats.histogram[bucket] < UINT16_MAX) {
+        stats.histogram[bucket]++;
+    }
+}
+
+void HALoopStats::reset()
+{
+    memset(_phases, 0, sizeof(_phases));
+}
+
+uint32_t HALoopStats::getMean(Phase phase) const
+{
+    const PhaseStats& stats = _phases[phase];
+    return (stats.count > 0 ? (stats.sum / stats.count) : 0);
+}
+
+uint32_t HALoopStats::now()
+{
+#if defined(ARDUINO)
+    return micros();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000000UL) + (ts.tv_nsec / 1000);
+#endif
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef AHA_HALOOPSTATS_H
+#define AHA_HALOOPSTATS_H
+
+#include <stdint.h>
+
+#include "ArduinoHADefines.h"
+
+#if defined(ARDUINOHA_LOOP_STATS)
+
+/**
+ * Latency statistics of the phases of HAMqtt::loop.
+ * Each phase keeps minimum, maximum and mean duration, and a histogram
+ * with logarithmic buckets: bucket N counts durations within [2^(N-1), 2^N) microseconds,
+ * the last bucket counts all longer durations.
+ */
+class HALoopStats
+{
+public:
+    static const uint8_t BucketsNb = 16;
+
+    enum Phase {
+        PhaseLoop = 0, // whole HAMqtt::loop
+        PhaseClientLoop, // loop of the MQTT client (including dispatch of messages)
+        PhaseDispatch, // HAMqtt::processMessage
+        PhaseConnect, // opening of the socket and MQTT handshake
+        PhaseDiscovery, // subscriptions and announcements
+        PhasePublishQueue,
+        PhaseTasks,
+        PhasesNb
+    };
+
+    struct PhaseStats {
+        uint32_t count;
+        uint32_t min; // us
+        uint32_t max; // us
+        uint64_t sum; // us
+        uint16_t histogram[BucketsNb];
+    };
+
+    /**
+     * Measures duration of the phase between its construction and destruction.
+     */
+    class Probe
+    {
+    public:
+        Probe(HALoopStats& stats, Phase phase);
+        ~Probe();
+
+    private:
+        HALoopStats& _stats;
+        const Phase _phase;
+        const uint32_t _startedAt;
+    };
+
+    HALoopStats();
+
+    /**
+     * Records single execution of the given phase.
+     *
+     * @param phase
+     * @param duration Duration in microseconds.
+     */
+    void record(Phase phase, uint32_t duration);
+
+    /**
+     * Clears statistics of all phases.
+     */
+    void reset();
+
+    inline const PhaseStats& get(Phase phase) const
+        { return _phases[phase]; }
+
+    /**
+     * Returns mean duration of the phase in microseconds.
+     *
+     * @param phase
+     */
+    uint32_t getMean(Phase phase) const;
+
+    /**
+     * Returns current time in microseconds.
+     */
+    static uint32_t now();
+
+private:
+    PhaseStats _phases[PhasesNb];
+};
+
+#define HAMQTT_LOOP_PROBE(phase) \
+    HALoopStats::Probe loopProbe(_loopStats, HALoopStats::phase)
+
+#else
+
+#define HAMQTT_LOOP_PROBE(phase)
+
+#endif
+#endif
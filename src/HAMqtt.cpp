@@ -1,9 +1,19 @@
-#include <PubSubClient.h>
-
 #include "HAMqtt.h"
 #include "HADevice.h"
+#include "HAUtils.h"
 #include "ArduinoHADefines.h"
 #include "device-types/BaseDeviceType.h"
+#include "device-types/DeviceTypeSerializer.h"
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+#define HAMQTT_RECEIVE_INIT \
+    , _receiveTopic(nullptr), \
+    _receiveTopicSize(0), \
+    _receiveLength(0), \
+    _receiveOverflow(false)
+#else
+#define HAMQTT_RECEIVE_INIT
+#endif
 
 #define HAMQTT_INIT \
     _netClient(netClient), \
@@ -11,44 +21,157 @@
     _hasDevice(true), \
     _initialized(false), \
     _discoveryPrefix(DefaultDiscoveryPrefix), \
-    _mqtt(new PubSubClient(netClient)), \
-    _serverIp(new IPAddress()), \
+    _client(netClient), \
+    _mqtt(_client) \
+    HAMQTT_RECEIVE_INIT, \
+    _serverIp(), \
     _serverPort(0), \
     _username(nullptr), \
     _password(nullptr), \
+    _persistentSession(false), \
+    _sessionPresent(false), \
+    _sessionSubscribed(false), \
+    _subscriptionsKept(false), \
+    _connectTimeout(DefaultConnectTimeout), \
+    _connectionState(StateDisconnected), \
     _lastConnectionAttemptAt(0), \
+    _reconnectInterval(0), \
+    _reconnectBackoff(ReconnectMinInterval), \
+    _nextDeviceTypeIndex(0), \
+    _discoveryBudget(DefaultDiscoveryBudget), \
+    _discoveryCallback(nullptr), \
+    _queueMessagesBudget(DefaultQueueMessagesBudget), \
+    _queueBytesBudget(DefaultQueueBytesBudget), \
     _devicesTypesNb(0), \
-    _devicesTypes(nullptr)
+    _subscriptionsNb(0), \
+    _hasUnownedSubscriptions(false), \
+    _wildcardSubscription(false), \
+    _publishQoS(0), \
+    _retransmitTimeout(DefaultRetransmitTimeout), \
+    _nextPacketId(1), \
+    _retransmitsNb(0), \
+    _acksNb(0), \
+    _ackLatencySum(0), \
+    _fingerprinting(false), \
+    _fingerprint(0), \
+    _birthMaxDelay(DefaultBirthMaxDelay), \
+    _discoveryScheduled(false), \
+    _discoveryScheduledAt(0), \
+    _discoveryDelay(0), \
+    _tasksBudget(DefaultTasksBudget), \
+    _publishedNb(0), \
+    _failedPublishesNb(0), \
+    _connectionsNb(0), \
+    _streaming(false), \
+    _streamBroadcast(false), \
+    _streamFirst(0), \
+    _streamLast(0), \
+    _deferredPublishing(false), \
+    _flushStalled(false)
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+#define HAMQTT_KEEPALIVE HAMqttClient::KeepAlive
+#else
+#define HAMQTT_KEEPALIVE MQTT_KEEPALIVE
+#endif
 
 static const char* DefaultDiscoveryPrefix = "homeassistant";
-static HAMqtt* instance = nullptr;
+static const char StatusTopic[] PROGMEM = {"/status"};
 
-void onMessageReceived(char* topic, uint8_t* payload, unsigned int length)
-{
-    if (instance == nullptr || length > UINT16_MAX) {
-        return;
-    }
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+// PubSubClient's callback doesn't carry any context, but messages are delivered
+// only from within PubSubClient::loop(). The pointer is set for the duration
+// of that call, so each instance receives only its own messages.
+static HAMqtt* loopingInstance = nullptr;
+#endif
 
-    instance->processMessage(topic, payload, static_cast<uint16_t>(length));
+static uint16_t calculateTopicHash(const char* topic, uint16_t* length)
+{
+    const uint32_t& hash = HAUtils::hash(topic, length);
+    return (hash >> 16) ^ (hash & 0xFFFF);
 }
 
 HAMqtt::HAMqtt(Client& netClient, HADevice& device) :
-    HAMQTT_INIT
+    HAMQTT_INIT,
+    _staticStorage(false),
+    _devicesTypesCapacity(0),
+    _devicesTypes(nullptr),
+    _subscriptionsCapacity(0),
+    _subscriptions(nullptr)
 {
-    instance = this;
+    _device._mqtt = this;
+
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    memset(_dirtySet, 0, sizeof(_dirtySet));
+#endif
 }
 
 HAMqtt::HAMqtt(const char* clientId, Client& netClient, HADevice& device) :
-    HAMQTT_INIT
+    HAMQTT_INIT,
+    _staticStorage(false),
+    _devicesTypesCapacity(0),
+    _devicesTypes(nullptr),
+    _subscriptionsCapacity(0),
+    _subscriptions(nullptr)
+{
+    _device._mqtt = this;
+
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    memset(_dirtySet, 0, sizeof(_dirtySet));
+#endif
+}
+
+HAMqtt::HAMqtt(
+    Client& netClient,
+    HADevice& device,
+    BaseDeviceType** devicesTypes,
+    uint16_t maxDevicesTypes,
+    HASubscription* subscriptions,
+    uint16_t maxSubscriptions,
+    char* receiveTopic,
+    uint16_t receiveTopicSize
+) :
+    HAMQTT_INIT,
+    _staticStorage(true),
+    _devicesTypesCapacity(maxDevicesTypes),
+    _devicesTypes(devicesTypes),
+    _subscriptionsCapacity(maxSubscriptions),
+    _subscriptions(subscriptions)
+{
+    _device._mqtt = this;
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    _receiveTopic = receiveTopic;
+    _receiveTopicSize = receiveTopicSize;
+    _mqtt.setTopicBuffer(_receiveTopic, _receiveTopicSize);
+#else
+    (void)receiveTopic;
+    (void)receiveTopicSize;
+#endif
+
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    memset(_dirtySet, 0, sizeof(_dirtySet));
+#endif
+}
+
+HAMqtt::~HAMqtt()
 {
-    instance = this;
+    if (!_staticStorage) {
+        ARDUINOHA_FREE(_devicesTypes);
+        ARDUINOHA_FREE(_subscriptions);
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+        ARDUINOHA_FREE(_receiveTopic);
+#endif
+    }
 }
 
 bool HAMqtt::begin(
     const IPAddress& serverIp,
     const uint16_t& serverPort,
     const char* username,
-    const char* password
+    const char* password,
+    bool persistentSession
 )
 {
 #if defined(ARDUINOHA_DEBUG)
@@ -76,14 +199,25 @@ bool HAMqtt::begin(
         return false;
     }
 
-    *_serverIp = serverIp;
+    _serverIp = serverIp;
     _serverPort = serverPort;
     _username = username;
     _password = password;
+    _persistentSession = persistentSession;
     _initialized = true;
 
-    _mqtt->setServer(*_serverIp, _serverPort);
-    _mqtt->setCallback(onMessageReceived);
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    _mqtt.setListener(this);
+#else
+    _mqtt.setServer(_serverIp, _serverPort);
+    _mqtt.setCallback(onMessageReceived);
+#endif
+
+    _mqtt.setSocketTimeout(_connectTimeout);
+
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    memset(_inFlight, 0, sizeof(_inFlight));
+#endif
 
     return true;
 }
@@ -99,51 +233,339 @@ bool HAMqtt::begin(
 
 void HAMqtt::loop()
 {
-    if (!_initialized) {
+    HAMQTT_LOOP_PROBE(PhaseLoop);
+
+    // network goes first, so the scheduled tasks can't delay keepalive
+    if (_initialized) {
+        processNetwork();
+    }
+
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+    {
+        HAMQTT_LOOP_PROBE(PhaseTasks);
+        _scheduler.run(_tasksBudget);
+    }
+#endif
+
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        _devicesTypes[i]->onMqttLoop();
+    }
+
+    // states set since the previous cycle (including the tasks above)
+    flush();
+}
+
+uint32_t HAMqtt::nextWakeupIn()
+{
+    uint32_t wakeupIn = UINT32_MAX;
+
+    if (_initialized) {
+        wakeupIn = nextNetworkWakeupIn();
+    }
+
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+    const uint32_t& taskIn = _scheduler.nextDueIn();
+    if (taskIn < wakeupIn) {
+        wakeupIn = taskIn;
+    }
+#endif
+
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    // stalled states are retried once the network makes progress (e.g. PUBACK)
+    for (uint16_t i = 0; i < sizeof(_dirtySet) && wakeupIn > 0 && !_flushStalled; i++) {
+        if (_dirtySet[i] != 0) {
+            wakeupIn = 0;
+        }
+    }
+#endif
+
+    for (uint16_t i = 0; i < _devicesTypesNb && wakeupIn > 0; i++) {
+        const uint32_t& deviceTypeIn = _devicesTypes[i]->nextLoopIn();
+        if (deviceTypeIn < wakeupIn) {
+            wakeupIn = deviceTypeIn;
+        }
+    }
+
+    return wakeupIn;
+}
+
+bool HAMqtt::schedule(
+    HASCHEDULER_CALLBACK,
+    uint32_t delay,
+    uint32_t interval,
+    void* context
+)
+{
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+    return _scheduler.schedule(callback, delay, interval, context);
+#else
+    return false;
+#endif
+}
+
+bool HAMqtt::cancel(HASCHEDULER_CALLBACK, void* context)
+{
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+    return _scheduler.cancel(callback, context);
+#else
+    return false;
+#endif
+}
+
+uint32_t HAMqtt::nextNetworkWakeupIn()
+{
+    if (_connectionState == StateDisconnected) {
+        return HAUtils::timeLeft(_lastConnectionAttemptAt, _reconnectInterval);
+    }
+
+    if (_connectionState != StateConnected || _client.available() > 0) {
+        return 0;
+    }
+
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+    if (!_publishQueue.isEmpty()) {
+        return 0;
+    }
+#endif
+
+    // the MQTT client sends PINGREQ once the keepalive is exceeded in either direction
+    const uint32_t& lastWriteAt = _client.getLastWriteAt();
+    const uint32_t& lastReadAt = _client.getLastReadAt();
+    uint32_t wakeupIn = HAUtils::timeLeft(
+        (ARDUINOHA_MILLIS() - lastWriteAt) > (ARDUINOHA_MILLIS() - lastReadAt) ? lastWriteAt : lastReadAt,
+        HAMQTT_KEEPALIVE * 1000UL + 1
+    );
+
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    for (uint8_t i = 0; i < ARDUINOHA_INFLIGHT_SIZE; i++) {
+        if (_inFlight[i].packetId == 0) {
+            continue;
+        }
+
+        const uint32_t& retransmitIn = HAUtils::timeLeft(
+            _inFlight[i].lastSentAt,
+            _retransmitTimeout
+        );
+        if (retransmitIn < wakeupIn) {
+            wakeupIn = retransmitIn;
+        }
+    }
+#endif
+
+    if (_discoveryScheduled) {
+        const uint32_t& discoveryIn = HAUtils::timeLeft(
+            _discoveryScheduledAt,
+            _discoveryDelay
+        );
+        if (discoveryIn < wakeupIn) {
+            wakeupIn = discoveryIn;
+        }
+    }
+
+    return wakeupIn;
+}
+
+void HAMqtt::processNetwork()
+{
+    // Messages stored in the session may arrive right away, so they're read
+    // once the registry is complete. Otherwise they wouldn't reach their owners.
+    const bool& registering = (_sessionPresent && _connectionState == StateSubscribing);
+
+    if (_connectionState >= StateSubscribing &&
+            !(registering ? isConnected() : loopClient())) {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Lost connection with the broker"));
+#endif
+
+        _reconnectBackoff = ReconnectMinInterval;
+        scheduleReconnect();
         return;
     }
 
-    if (!_mqtt->loop()) {
-        connectToServer();
+    connectToServer();
+
+    if (_connectionState == StateConnected) {
+        processRetransmissions();
+        processPublishQueue();
+        processScheduledDiscovery();
     }
 }
 
+bool HAMqtt::loopClient()
+{
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    // messages and acknowledgements are delivered through the listener's methods
+    HAMQTT_LOOP_PROBE(PhaseClientLoop);
+    return _mqtt.loop();
+#else
+    processAcknowledgements();
+
+    HAMqtt* previousInstance = loopingInstance;
+    loopingInstance = this;
+
+    HAMQTT_LOOP_PROBE(PhaseClientLoop);
+    const bool& connected = _mqtt.loop();
+
+    loopingInstance = previousInstance;
+    return connected;
+#endif
+}
+
 bool HAMqtt::isConnected()
 {
-    return _mqtt->connected();
+    return _mqtt.connected();
+}
+
+bool HAMqtt::flush()
+{
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    bool buffering = false;
+    _flushStalled = false;
+
+    for (uint16_t i = 0; i < sizeof(_dirtySet); i++) {
+        // devices types marked during the flush are published in the next one
+        const uint8_t bits = _dirtySet[i];
+        if (bits == 0) {
+            continue;
+        }
+
+        _dirtySet[i] = 0;
+
+        if (!buffering) {
+            _client.beginBuffering();
+            buffering = true;
+        }
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (!(bits & (1 << bit)) ||
+                    _devicesTypes[i * 8 + bit]->onMqttFlush()) {
+                continue;
+            }
+
+            // The state couldn't be published (e.g. the in-flight table and the queue are full),
+            // so it's kept for the next flush. States that failed while disconnected
+            // are published by the discovery after the reconnect.
+            if (isConnected()) {
+                _dirtySet[i] |= (1 << bit);
+                _flushStalled = true;
+            }
+        }
+    }
+
+    return (buffering ? _client.endBuffering() : true);
+#else
+    return true;
+#endif
+}
+
+bool HAMqtt::markDirty(BaseDeviceType* deviceType)
+{
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    const uint16_t& index = deviceType->_index;
+    if (!_deferredPublishing ||
+            index >= ARDUINOHA_DIRTY_SET_SIZE ||
+            index >= _devicesTypesNb) {
+        return false;
+    }
+
+    _dirtySet[index / 8] |= (1 << (index % 8));
+    _flushStalled = false;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HAMqtt::forceDiscovery()
+{
+    for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+        _devicesTypes[i]->setConfigHash(0);
+    }
+
+    if (_connectionState >= StateAnnouncing) {
+        _connectionState = StateAnnouncing;
+        _nextDeviceTypeIndex = 0;
+    }
 }
 
 void HAMqtt::addDeviceType(BaseDeviceType* deviceType)
 {
-    BaseDeviceType** data = (BaseDeviceType**)realloc(
-        _devicesTypes,
-        sizeof(BaseDeviceType*) * (_devicesTypesNb + 1)
-    );
+    if (_devicesTypesNb == _devicesTypesCapacity) {
+        // the last index is reserved for devices types that aren't registered
+        if (_staticStorage || _devicesTypesCapacity == UINT16_MAX - 1) {
+#if defined(ARDUINOHA_DEBUG)
+            Serial.println(F("Failed to add device type. Storage is full."));
+#endif
+
+            return;
+        }
+
+        BaseDeviceType** data = (BaseDeviceType**)ARDUINOHA_REALLOC(
+            _devicesTypes,
+            sizeof(BaseDeviceType*) * (_devicesTypesCapacity + 1)
+        );
+
+        if (data == nullptr) {
+            return;
+        }
 
-    if (data != nullptr) {
         _devicesTypes = data;
-        _devicesTypes[_devicesTypesNb] = deviceType;
-        _devicesTypesNb++;
+        _devicesTypesCapacity++;
     }
+
+    deviceType->_index = _devicesTypesNb;
+    _devicesTypes[_devicesTypesNb] = deviceType;
+    _devicesTypesNb++;
+
+    // topics of the new device type aren't subscribed within the session yet
+    _sessionSubscribed = false;
 }
 
 bool HAMqtt::publish(const char* topic, const char* payload, bool retained)
 {
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+    // queued messages need to be published first in order to keep the order of states
+    if (!isConnected() || !_publishQueue.isEmpty()) {
+        if (_publishQueue.push(topic, payload, retained)) {
+#if defined(ARDUINOHA_DEBUG)
+            Serial.print(F("Queued message with topic: "));
+            Serial.print(topic);
+            Serial.println();
+#endif
+
+            return true;
+        }
+
+        if (!_publishQueue.isEmpty()) {
+#if defined(ARDUINOHA_DEBUG)
+            Serial.println(F("Failed to queue message behind the queued ones."));
+#endif
+
+            // publishing the message right away would overtake the queued ones
+            _failedPublishesNb++;
+            return false;
+        }
+    }
+#endif
+
     if (!isConnected()) {
+        _failedPublishesNb++;
         return false;
     }
 
-#if defined(ARDUINOHA_DEBUG)
-    Serial.print(F("Publishing message with topic: "));
-    Serial.print(topic);
-    Serial.print(F(", payload length: "));
-    Serial.print(strlen(payload));
-    Serial.println();
+    if (publishMessage(topic, payload, retained)) {
+        return true;
+    }
+
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+    // e.g. the in-flight table is full
+    if (_publishQueue.push(topic, payload, retained)) {
+        return true;
+    }
 #endif
 
-    _mqtt->beginPublish(topic, strlen(payload), retained);
-    _mqtt->write((const uint8_t*)(payload), strlen(payload));
-    return _mqtt->endPublish();
+    _failedPublishesNb++;
+    return false;
 }
 
 bool HAMqtt::beginPublish(
@@ -152,6 +574,11 @@ bool HAMqtt::beginPublish(
     bool retained
 )
 {
+    if (_fingerprinting) {
+        // topics of all messages are the part of the fingerprint
+        return writeRaw((const uint8_t*)(topic), strlen(topic));
+    }
+
 #if defined(ARDUINOHA_DEBUG)
     Serial.print(F("Publishing message with topic: "));
     Serial.print(topic);
@@ -160,28 +587,93 @@ bool HAMqtt::beginPublish(
     Serial.println();
 #endif
 
-    return _mqtt->beginPublish(topic, payloadLength, retained);
+    _client.beginBuffering();
+
+    if (!_mqtt.beginPublish(topic, payloadLength, retained)) {
+        _client.endBuffering();
+        _failedPublishesNb++;
+        return false;
+    }
+
+    return true;
 }
 
 bool HAMqtt::writePayload(const char* data, uint16_t length)
 {
-    return (_mqtt->write((const uint8_t*)(data), length) > 0);
+    return writeRaw((const uint8_t*)(data), length);
 }
 
 bool HAMqtt::writePayload_P(const char* src)
 {
-    char data[strlen_P(src) + 1];
-    strcpy_P(data, src);
+    // flash data is streamed in chunks, so the string is scanned only once
+    uint8_t chunk[ProgmemChunkSize];
+    uint8_t chunkLength = 0;
+    bool result = true;
+    char c;
+
+    while ((c = pgm_read_byte(src++)) != '\0') {
+        chunk[chunkLength++] = c;
+
+        if (chunkLength == ProgmemChunkSize) {
+            result &= writeRaw(chunk, chunkLength);
+            chunkLength = 0;
+        }
+    }
+
+    if (chunkLength > 0) {
+        result &= writeRaw(chunk, chunkLength);
+    }
 
-    return _mqtt->write((const uint8_t*)(data), strlen(data));
+    return result;
 }
 
 bool HAMqtt::endPublish()
 {
-    return _mqtt->endPublish();
+    if (_fingerprinting) {
+        return true;
+    }
+
+    const bool& flushed = _client.endBuffering();
+    if (!_mqtt.endPublish() || !flushed) {
+        _failedPublishesNb++;
+        return false;
+    }
+
+    _publishedNb++;
+    return true;
+}
+
+void HAMqtt::beginFingerprint(const char* topic)
+{
+    _fingerprinting = true;
+    _fingerprint = HAUtils::HashOffsetBasis;
+
+    if (topic != nullptr) {
+        _fingerprint = HAUtils::updateHash(
+            _fingerprint,
+            (const uint8_t*)(topic),
+            strlen(topic)
+        );
+    }
+}
+
+uint32_t HAMqtt::endFingerprint()
+{
+    _fingerprinting = false;
+    return _fingerprint;
+}
+
+bool HAMqtt::writeRaw(const uint8_t* data, uint16_t length)
+{
+    if (_fingerprinting) {
+        _fingerprint = HAUtils::updateHash(_fingerprint, data, length);
+        return true;
+    }
+
+    return (_mqtt.write(data, length) > 0);
 }
 
-bool HAMqtt::subscribe(const char* topic)
+bool HAMqtt::subscribe(const char* topic, BaseDeviceType* owner)
 {
 #if defined(ARDUINOHA_DEBUG)
     Serial.print(F("Subscribing topic: "));
@@ -189,11 +681,24 @@ bool HAMqtt::subscribe(const char* topic)
     Serial.println();
 #endif
 
-    return _mqtt->subscribe(topic);
+    registerSubscription(topic, owner);
+
+    if (_subscriptionsKept && _connectionState == StateSubscribing) {
+        return true; // the broker kept subscriptions of the session
+    }
+
+    if (_wildcardSubscription && isDeviceCommandTopic(topic)) {
+        return true; // covered by the wildcard subscription
+    }
+
+    // QoS 1 allows the broker to keep commands sent while the device is offline
+    return _mqtt.subscribe(topic, _persistentSession ? 1 : 0);
 }
 
 void HAMqtt::processMessage(char* topic, uint8_t* payload, uint16_t length)
 {
+    HAMQTT_LOOP_PROBE(PhaseDispatch);
+
 #if defined(ARDUINOHA_DEBUG)
     Serial.print(F("Received message on topic: "));
     Serial.print(topic);
@@ -202,48 +707,811 @@ void HAMqtt::processMessage(char* topic, uint8_t* payload, uint16_t length)
     Serial.println();
 #endif
 
-    for (uint8_t i = 0; i < _devicesTypesNb; i++) {
-        _devicesTypes[i]->onMqttMessage(topic, payload, length);
+    if (isStatusTopic(topic)) {
+        const uint16_t& onlineLength = strlen(DeviceTypeSerializer::Online);
+
+        if (length == onlineLength &&
+                memcmp(payload, DeviceTypeSerializer::Online, length) == 0) {
+            // Home Assistant has been started, all devices types need to be announced again
+            _discoveryScheduled = true;
+            _discoveryScheduledAt = ARDUINOHA_MILLIS();
+            _discoveryDelay = random(_birthMaxDelay + 1);
+        }
+
+        return;
+    }
+
+    uint16_t first = 0;
+    uint16_t last = 0;
+
+    if (findReceivers(topic, &first, &last)) {
+        for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+            _devicesTypes[i]->onMqttMessage(topic, payload, length);
+        }
+
+        return;
+    }
+
+    // owners perform exact comparison of the topic
+    for (uint16_t i = first; i < last; i++) {
+        _subscriptions[i].owner->onMqttMessage(topic, payload, length);
     }
 }
 
-void HAMqtt::connectToServer()
+bool HAMqtt::findReceivers(const char* topic, uint16_t* first, uint16_t* last) const
+{
+    uint16_t topicLength = 0;
+    const uint16_t& hash = calculateTopicHash(topic, &topicLength);
+    bool broadcast = false;
+
+    *first = findSubscription(hash, topicLength);
+    *last = *first;
+
+    for (; *last < _subscriptionsNb; (*last)++) {
+        const HASubscription& subscription = _subscriptions[*last];
+        if (subscription.hash != hash || subscription.length != topicLength) {
+            break;
+        }
+
+        if (subscription.owner == nullptr) {
+            broadcast = true;
+        }
+    }
+
+    if (*first == *last && _hasUnownedSubscriptions) {
+        broadcast = true;
+    }
+
+    return broadcast;
+}
+
+void HAMqtt::beginMessage(const char* topic, uint32_t length)
 {
-    if (_lastConnectionAttemptAt > 0 &&
-            (millis() - _lastConnectionAttemptAt) < ReconnectInterval) {
+    // Home Assistant's status is handled only by the HAMqtt
+    _streaming = !isStatusTopic(topic);
+    if (!_streaming) {
         return;
     }
 
-    _lastConnectionAttemptAt = millis();
+    _streamBroadcast = findReceivers(topic, &_streamFirst, &_streamLast);
 
-#if defined(ARDUINOHA_DEBUG)
-    Serial.print(F("Connecting to the MQTT broker... Client ID: "));
-    Serial.print(_device.getUniqueId());
-    Serial.println();
-#endif
+    if (_streamBroadcast) {
+        for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+            _devicesTypes[i]->onMqttMessageBegin(topic, length);
+        }
+    } else {
+        for (uint16_t i = _streamFirst; i < _streamLast; i++) {
+            _subscriptions[i].owner->onMqttMessageBegin(topic, length);
+        }
+    }
+}
+
+void HAMqtt::streamMessage(const uint8_t* data, uint16_t length)
+{
+    if (!_streaming) {
+        return;
+    }
 
-    if (_username == nullptr || _password == nullptr) {
-        _mqtt->connect(_device.getUniqueId());
+    if (_streamBroadcast) {
+        for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+            _devicesTypes[i]->onMqttMessageData(data, length);
+        }
     } else {
-        _mqtt->connect(_device.getUniqueId(), _username, _password);
+        for (uint16_t i = _streamFirst; i < _streamLast; i++) {
+            _subscriptions[i].owner->onMqttMessageData(data, length);
+        }
     }
+}
 
-    if (isConnected()) {
-#if defined(ARDUINOHA_DEBUG)
-        Serial.println(F("Connected to the broker"));
-#endif
+void HAMqtt::endMessage()
+{
+    if (!_streaming) {
+        return;
+    }
 
-        onConnected();
+    _streaming = false;
+
+    if (_streamBroadcast) {
+        for (uint16_t i = 0; i < _devicesTypesNb; i++) {
+            _devicesTypes[i]->onMqttMessageEnd();
+        }
     } else {
+        for (uint16_t i = _streamFirst; i < _streamLast; i++) {
+            _subscriptions[i].owner->onMqttMessageEnd();
+        }
+    }
+}
+
+void HAMqtt::subscribeStatus()
+{
+    char topic[strlen(_discoveryPrefix) + strlen_P(StatusTopic) + 1]; // with null terminator
+    strcpy(topic, _discoveryPrefix);
+    strcat_P(topic, StatusTopic);
+    reserveReceiveTopic(sizeof(topic) - 1);
+
 #if defined(ARDUINOHA_DEBUG)
-        Serial.println(F("Failed to connect to the broker"));
+    Serial.print(F("Subscribing topic: "));
+    Serial.print(topic);
+    Serial.println();
 #endif
+
+    _mqtt.subscribe(topic, _persistentSession ? 1 : 0);
+}
+
+bool HAMqtt::isStatusTopic(const char* topic) const
+{
+    const uint16_t& prefixLength = strlen(_discoveryPrefix);
+
+    return (
+        strncmp(topic, _discoveryPrefix, prefixLength) == 0 &&
+        strcmp_P(&topic[prefixLength], StatusTopic) == 0
+    );
+}
+
+void HAMqtt::processScheduledDiscovery()
+{
+    if (!_discoveryScheduled ||
+            (ARDUINOHA_MILLIS() - _discoveryScheduledAt) < _discoveryDelay) {
+        return;
     }
+
+#if defined(ARDUINOHA_DEBUG)
+    Serial.println(F("Home Assistant has been started. Announcing devices types..."));
+#endif
+
+    _discoveryScheduled = false;
+    forceDiscovery();
 }
 
-void HAMqtt::onConnected()
+void HAMqtt::subscribeCommandWildcard()
 {
-    for (uint8_t i = 0; i < _devicesTypesNb; i++) {
-        _devicesTypes[i]->onMqttConnected();
+    static const char Wildcard[] PROGMEM = {"/+/"};
+
+    // [discovery prefix]/+/[device ID]/+/cmd
+    char topic[
+        strlen(_discoveryPrefix) +
+        strlen(_device.getUniqueId()) +
+        strlen(DeviceTypeSerializer::CommandTopic) +
+        7 // two wildcards with slashes + null terminator
+    ];
+
+    strcpy(topic, _discoveryPrefix);
+    strcat_P(topic, Wildcard);
+    strcat(topic, _device.getUniqueId());
+    strcat_P(topic, Wildcard);
+    strcat(topic, DeviceTypeSerializer::CommandTopic);
+
+#if defined(ARDUINOHA_DEBUG)
+    Serial.print(F("Subscribing topic: "));
+    Serial.print(topic);
+    Serial.println();
+#endif
+
+    _mqtt.subscribe(topic, _persistentSession ? 1 : 0);
+}
+
+bool HAMqtt::isDeviceCommandTopic(const char* topic) const
+{
+    const uint16_t& prefixLength = strlen(_discoveryPrefix);
+    if (strncmp(topic, _discoveryPrefix, prefixLength) != 0 ||
+            topic[prefixLength] != '/') {
+        return false;
+    }
+
+    // component
+    const char* segment = topic + prefixLength + 1;
+    const char* slash = strchr(segment, '/');
+    if (slash == nullptr || slash == segment) {
+        return false;
+    }
+
+    // device ID
+    segment = slash + 1;
+    const uint16_t& uniqueIdLength = strlen(_device.getUniqueId());
+    if (strncmp(segment, _device.getUniqueId(), uniqueIdLength) != 0 ||
+            segment[uniqueIdLength] != '/') {
+        return false;
+    }
+
+    // object ID
+    segment += uniqueIdLength + 1;
+    slash = strchr(segment, '/');
+    if (slash == nullptr || slash == segment) {
+        return false;
+    }
+
+    return (strcmp(slash + 1, DeviceTypeSerializer::CommandTopic) == 0);
+}
+
+void HAMqtt::registerSubscription(const char* topic, BaseDeviceType* owner)
+{
+    if (owner == nullptr) {
+        _hasUnownedSubscriptions = true;
+    }
+
+    uint16_t length = 0;
+    const uint16_t& hash = calculateTopicHash(topic, &length);
+
+    reserveReceiveTopic(length);
+
+    const uint16_t& index = findSubscription(hash, length);
+    for (uint16_t i = index; i < _subscriptionsNb; i++) {
+        if (_subscriptions[i].hash != hash || _subscriptions[i].length != length) {
+            break;
+        }
+
+        if (_subscriptions[i].owner == owner) {
+            return; // already registered
+        }
+    }
+
+    if (_subscriptionsNb == _subscriptionsCapacity) {
+        if (_staticStorage || _subscriptionsCapacity == UINT16_MAX) {
+#if defined(ARDUINOHA_DEBUG)
+            Serial.println(F("Failed to register subscription. Storage is full."));
+#endif
+
+            return;
+        }
+
+        HASubscription* data = (HASubscription*)ARDUINOHA_REALLOC(
+            _subscriptions,
+            sizeof(HASubscription) * (_subscriptionsCapacity + 1)
+        );
+
+        if (data == nullptr) {
+            return;
+        }
+
+        _subscriptions = data;
+        _subscriptionsCapacity++;
+    }
+
+    memmove(
+        &_subscriptions[index + 1],
+        &_subscriptions[index],
+        sizeof(HASubscription) * (_subscriptionsNb - index)
+    );
+
+    _subscriptions[index].hash = hash;
+    _subscriptions[index].length = length;
+    _subscriptions[index].owner = owner;
+    _subscriptionsNb++;
+}
+
+void HAMqtt::reserveReceiveTopic(uint16_t length)
+{
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    if (_staticStorage || length < _receiveTopicSize || length == UINT16_MAX) {
+        return;
+    }
+
+    // realloc preserves the topic that may be partially received
+    char* data = (char*)ARDUINOHA_REALLOC(_receiveTopic, length + 1);
+    if (data == nullptr) {
+        return;
+    }
+
+    _receiveTopic = data;
+    _receiveTopicSize = length + 1;
+    _mqtt.setTopicBuffer(_receiveTopic, _receiveTopicSize);
+#else
+    (void)length;
+#endif
+}
+
+uint16_t HAMqtt::findSubscription(uint16_t hash, uint16_t length) const
+{
+    uint16_t low = 0;
+    uint16_t high = _subscriptionsNb;
+
+    while (low < high) {
+        const uint16_t& mid = low + (high - low) / 2;
+        const HASubscription& subscription = _subscriptions[mid];
+
+        if (subscription.hash < hash ||
+                (subscription.hash == hash && subscription.length < length)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+void HAMqtt::connectToServer()
+{
+    switch (_connectionState) {
+        case StateDisconnected:
+            openSocket();
+            break;
+
+        case StateSocketOpened:
+            performHandshake();
+            break;
+
+        case StateSubscribing:
+        case StateAnnouncing:
+            processDiscovery();
+            break;
+
+        case StateConnected:
+            break;
+    }
+}
+
+void HAMqtt::openSocket()
+{
+    HAMQTT_LOOP_PROBE(PhaseConnect);
+
+    if (_reconnectInterval > 0 &&
+            (ARDUINOHA_MILLIS() - _lastConnectionAttemptAt) < _reconnectInterval) {
+        return;
+    }
+
+    _lastConnectionAttemptAt = ARDUINOHA_MILLIS();
+
+#if defined(ARDUINOHA_DEBUG)
+    Serial.println(F("Opening connection with the MQTT broker..."));
+#endif
+
+    if (_netClient.connect(_serverIp, _serverPort) != 1) {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Failed to open connection with the broker"));
+#endif
+
+        _netClient.stop();
+        scheduleReconnect();
+        return;
+    }
+
+    _connectionState = StateSocketOpened;
+}
+
+void HAMqtt::performHandshake()
+{
+    HAMQTT_LOOP_PROBE(PhaseConnect);
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    if (!_mqtt.isConnecting()) {
+        sendConnect();
+    }
+
+    // the CONNACK is awaited without blocking the loop
+    _mqtt.loop();
+
+    if (_mqtt.isConnecting()) {
+        return;
+    }
+#else
+    sendConnect();
+#endif
+
+    if (isConnected()) {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Connected to the broker"));
+#endif
+
+        onConnected();
+    } else {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Failed to connect to the broker"));
+#endif
+
+        scheduleReconnect();
+    }
+}
+
+void HAMqtt::sendConnect()
+{
+#if defined(ARDUINOHA_DEBUG)
+    Serial.print(F("Connecting to the MQTT broker... Client ID: "));
+    Serial.print(_device.getUniqueId());
+    Serial.println();
+#endif
+
+    const bool& hasCredentials = (_username != nullptr && _password != nullptr);
+    const uint16_t& willTopicSize = (
+        _device.isLastWillEnabled() ?
+        DeviceTypeSerializer::calculateDeviceAvailabilityTopicLength(this) :
+        0
+    );
+    char willTopic[willTopicSize > 0 ? willTopicSize : 1];
+
+    if (willTopicSize > 0) {
+        DeviceTypeSerializer::generateDeviceAvailabilityTopic(this, willTopic);
+    }
+
+    _client.expectConnAck();
+
+    // both clients reuse the socket that's already opened
+    _mqtt.connect(
+        _device.getUniqueId(),
+        hasCredentials ? _username : nullptr,
+        hasCredentials ? _password : nullptr,
+        willTopicSize > 0 ? willTopic : nullptr,
+        0,
+        true,
+        willTopicSize > 0 ? DeviceTypeSerializer::Offline : nullptr,
+        !_persistentSession
+    );
+}
+
+void HAMqtt::onConnected()
+{
+    _connectionsNb++;
+    _reconnectBackoff = ReconnectMinInterval;
+    _nextDeviceTypeIndex = 0;
+    _sessionPresent = (_persistentSession && _client.isSessionPresent());
+    _connectionState = StateSubscribing;
+
+    // The session may come from the previous firmware that subscribed different topics,
+    // so it's trusted only if all topics were subscribed within it since the boot.
+    _subscriptionsKept = (_sessionPresent && _sessionSubscribed);
+    _sessionSubscribed = false;
+
+    // the will message (if any) is retained so it needs to be overwritten
+    _device.publishAvailability();
+
+    if (_subscriptionsKept) {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Session is present. Skipping subscriptions."));
+#endif
+
+        // The registry is still built by the time-sliced discovery,
+        // but no packets are sent in this case (see `subscribe`).
+        return;
+    }
+
+    subscribeStatus();
+
+    if (_wildcardSubscription) {
+        subscribeCommandWildcard();
+    }
+}
+
+void HAMqtt::processDiscovery()
+{
+    HAMQTT_LOOP_PROBE(PhaseDiscovery);
+
+    const uint32_t& startedAt = ARDUINOHA_MILLIS();
+
+    do {
+        if (_nextDeviceTypeIndex >= _devicesTypesNb) {
+            _nextDeviceTypeIndex = 0;
+
+            if (_connectionState == StateSubscribing) {
+                _connectionState = StateAnnouncing;
+                _sessionSubscribed = _persistentSession;
+                continue;
+            }
+
+#if defined(ARDUINOHA_DEBUG)
+            Serial.println(F("Discovery completed"));
+#endif
+
+            _connectionState = StateConnected;
+
+            if (_discoveryCallback != nullptr) {
+                _discoveryCallback();
+            }
+
+            return;
+        }
+
+        BaseDeviceType* deviceType = _devicesTypes[_nextDeviceTypeIndex++];
+        if (_connectionState == StateSubscribing) {
+            deviceType->onMqttSubscribe();
+        } else {
+            deviceType->onMqttConnected();
+        }
+    } while ((ARDUINOHA_MILLIS() - startedAt) < _discoveryBudget);
+}
+
+void HAMqtt::processPublishQueue()
+{
+    HAMQTT_LOOP_PROBE(PhasePublishQueue);
+
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+    uint8_t messagesNb = 0;
+    uint16_t bytesNb = 0;
+
+    while (!_publishQueue.isEmpty() && messagesNb < _queueMessagesBudget) {
+        const HAPublishQueue::Message* message = _publishQueue.front();
+        const uint16_t& length = strlen(message->topic) + strlen(message->payload);
+
+        if (messagesNb > 0 && (bytesNb + length) > _queueBytesBudget) {
+            break;
+        }
+
+        if (!publishMessage(message->topic, message->payload, message->retained)) {
+            break;
+        }
+
+        _publishQueue.pop();
+        messagesNb++;
+        bytesNb += length;
+    }
+#endif
+}
+
+bool HAMqtt::publishMessage(const char* topic, const char* payload, bool retained)
+{
+#if defined(ARDUINOHA_DEBUG)
+    Serial.print(F("Publishing message with topic: "));
+    Serial.print(topic);
+    Serial.print(F(", payload length: "));
+    Serial.print(strlen(payload));
+    Serial.println();
+#endif
+
+    const uint16_t& payloadLength = strlen(payload);
+
+    // the message would be lost if it was rejected because of its size
+    if (_publishQoS > 0 &&
+            (strlen(topic) >= ARDUINOHA_INFLIGHT_TOPIC_SIZE ||
+            payloadLength >= ARDUINOHA_INFLIGHT_PAYLOAD_SIZE)) {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Message doesn't fit the in-flight slot. Publishing with QoS 0."));
+#endif
+    } else if (_publishQoS > 0) {
+        if (!publishQoS1Message(topic, payload, retained)) {
+            return false;
+        }
+
+        _publishedNb++;
+        return true;
+    }
+
+    _client.beginBuffering();
+
+    if (!_mqtt.beginPublish(topic, payloadLength, retained)) {
+        _client.endBuffering();
+        return false;
+    }
+
+    _mqtt.write((const uint8_t*)(payload), payloadLength);
+
+    const bool& flushed = _client.endBuffering();
+    if (!_mqtt.endPublish() || !flushed) {
+        return false;
+    }
+
+    _publishedNb++;
+    return true;
+}
+
+uint8_t HAMqtt::getInFlightNb() const
+{
+    uint8_t nb = 0;
+
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    for (uint8_t i = 0; i < ARDUINOHA_INFLIGHT_SIZE; i++) {
+        if (_inFlight[i].packetId != 0) {
+            nb++;
+        }
+    }
+#endif
+
+    return nb;
+}
+
+bool HAMqtt::publishQoS1Message(const char* topic, const char* payload, bool retained)
+{
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    if (strlen(topic) >= ARDUINOHA_INFLIGHT_TOPIC_SIZE ||
+            strlen(payload) >= ARDUINOHA_INFLIGHT_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    HAInFlightMessage* message = nullptr;
+    for (uint8_t i = 0; i < ARDUINOHA_INFLIGHT_SIZE; i++) {
+        if (_inFlight[i].packetId == 0) {
+            message = &_inFlight[i];
+            break;
+        }
+    }
+
+    if (message == nullptr) {
+        return false;
+    }
+
+    message->packetId = _nextPacketId++;
+    message->firstSentAt = ARDUINOHA_MILLIS();
+    message->lastSentAt = message->firstSentAt;
+    message->retained = retained;
+    strcpy(message->topic, topic);
+    strcpy(message->payload, payload);
+
+    if (_nextPacketId == 0) {
+        _nextPacketId = 1;
+    }
+
+    // unacknowledged message will be retransmitted, so it's considered as published
+    writeQoS1Packet(message, false);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool HAMqtt::writeQoS1Packet(const HAInFlightMessage* message, bool duplicate)
+{
+#if defined(ARDUINOHA_DEBUG)
+    Serial.print(F("Publishing QoS 1 message with topic: "));
+    Serial.print(message->topic);
+    Serial.print(F(", packet ID: "));
+    Serial.print(message->packetId);
+    Serial.println();
+#endif
+
+    const uint16_t& topicLength = strlen(message->topic);
+    const uint16_t& payloadLength = strlen(message->payload);
+    uint32_t remainingLength = 2 + topicLength + 2 + payloadLength; // with topic length and packet ID
+    uint8_t header[5 + 2]; // fixed header + topic length
+    uint8_t headerLength = 0;
+
+    header[headerLength++] = 0x32 | (duplicate ? 0x08 : 0x00) | (message->retained ? 0x01 : 0x00);
+
+    do {
+        uint8_t digit = remainingLength % 128;
+        remainingLength /= 128;
+
+        if (remainingLength > 0) {
+            digit |= 0x80;
+        }
+
+        header[headerLength++] = digit;
+    } while (remainingLength > 0);
+
+    header[headerLength++] = (topicLength >> 8);
+    header[headerLength++] = (topicLength & 0xFF);
+
+    const uint8_t packetId[2] = {
+        (uint8_t)(message->packetId >> 8),
+        (uint8_t)(message->packetId & 0xFF)
+    };
+
+    // written through the MQTT client, so it knows that the connection is active
+    _client.beginBuffering();
+    _mqtt.write(header, headerLength);
+    _mqtt.write((const uint8_t*)message->topic, topicLength);
+    _mqtt.write(packetId, 2);
+    _mqtt.write((const uint8_t*)message->payload, payloadLength);
+
+    return _client.endBuffering();
+}
+
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+void HAMqtt::processAcknowledgements()
+{
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    // PUBACK: 0x40, remaining length (2), packet ID (2 bytes)
+    while (_client.available() >= 4 && _client.peek() == 0x40) {
+        uint8_t packet[4];
+        if (_client.read(packet, 4) != 4) {
+            return;
+        }
+
+        acknowledgeMessage((packet[2] << 8) | packet[3]);
+    }
+#endif
+}
+#endif
+
+void HAMqtt::acknowledgeMessage(uint16_t packetId)
+{
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    for (uint8_t i = 0; i < ARDUINOHA_INFLIGHT_SIZE; i++) {
+        HAInFlightMessage* message = &_inFlight[i];
+        if (message->packetId != packetId) {
+            continue;
+        }
+
+        _acksNb++;
+        _ackLatencySum += (ARDUINOHA_MILLIS() - message->firstSentAt);
+        message->packetId = 0;
+        break;
+    }
+#endif
+}
+
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+void HAMqtt::onMessageReceived(char* topic, uint8_t* payload, unsigned int length)
+{
+    if (loopingInstance == nullptr) {
+        return;
+    }
+
+    loopingInstance->beginMessage(topic, length);
+
+    for (unsigned int offset = 0; offset < length; offset += UINT16_MAX) {
+        const unsigned int& left = length - offset;
+        loopingInstance->streamMessage(
+            &payload[offset],
+            left > UINT16_MAX ? UINT16_MAX : left
+        );
+    }
+
+    loopingInstance->endMessage();
+
+    if (length <= UINT16_MAX) {
+        loopingInstance->processMessage(topic, payload, static_cast<uint16_t>(length));
+    }
+}
+#else
+void HAMqtt::onMessageBegin(char* topic, uint32_t length)
+{
+    _receiveLength = 0;
+    _receiveOverflow = (length > ARDUINOHA_RECEIVE_PAYLOAD_SIZE);
+
+#if defined(ARDUINOHA_DEBUG)
+    if (_receiveOverflow) {
+        Serial.print(F("Streaming message on topic: "));
+        Serial.print(topic);
+        Serial.println(F(". Payload is too long for the receive buffer."));
+    }
+#endif
+
+    beginMessage(topic, length);
+}
+
+void HAMqtt::onMessageData(const uint8_t* data, uint16_t length)
+{
+    streamMessage(data, length);
+
+    if (_receiveOverflow) {
+        return;
+    }
+
+    memcpy(&_receiveBuffer[_receiveLength], data, length);
+    _receiveLength += length;
+}
+
+void HAMqtt::onMessageEnd()
+{
+    endMessage();
+
+    if (!_receiveOverflow) {
+        // the buffer might have been reallocated since the topic was received
+        processMessage(_receiveTopic, _receiveBuffer, _receiveLength);
+    }
+}
+
+void HAMqtt::onPubAck(uint16_t packetId)
+{
+    acknowledgeMessage(packetId);
+}
+#endif
+
+void HAMqtt::processRetransmissions()
+{
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    for (uint8_t i = 0; i < ARDUINOHA_INFLIGHT_SIZE; i++) {
+        HAInFlightMessage* message = &_inFlight[i];
+        if (message->packetId == 0 ||
+                (ARDUINOHA_MILLIS() - message->lastSentAt) < _retransmitTimeout) {
+            continue;
+        }
+
+        message->lastSentAt = ARDUINOHA_MILLIS();
+        _retransmitsNb++;
+
+        writeQoS1Packet(message, true);
+    }
+#endif
+}
+
+void HAMqtt::scheduleReconnect()
+{
+    // "equal jitter" - the interval is randomized within upper half of the backoff
+    _lastConnectionAttemptAt = ARDUINOHA_MILLIS();
+    _reconnectInterval = (_reconnectBackoff / 2) + random((_reconnectBackoff / 2) + 1);
+    _reconnectBackoff *= 2;
+    _connectionState = StateDisconnected;
+
+    if (_reconnectBackoff > ReconnectMaxInterval) {
+        _reconnectBackoff = ReconnectMaxInterval;
     }
 }
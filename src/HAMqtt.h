@@ -4,17 +4,65 @@
 #include <Client.h>
 #include <IPAddress.h>
 
-class PubSubClient;
+#include "ArduinoHADefines.h"
+#include "HANetClient.h"
+#include "HAMqttClient.h"
+#include "HAPublishQueue.h"
+#include "HAScheduler.h"
+#include "HALoopStats.h"
+
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+#include <PubSubClient.h>
+#endif
+
+#define HAMQTT_DISCOVERY_CALLBACK void (*callback)()
+
 class HADevice;
 class BaseDeviceType;
 
+struct HASubscription {
+    uint16_t hash;
+    uint16_t length;
+    BaseDeviceType* owner;
+};
+
+struct HAInFlightMessage {
+    uint16_t packetId; // 0 means that the slot is free
+    uint32_t firstSentAt;
+    uint32_t lastSentAt;
+    bool retained;
+    char topic[ARDUINOHA_INFLIGHT_TOPIC_SIZE];
+    char payload[ARDUINOHA_INFLIGHT_PAYLOAD_SIZE];
+};
+
 class HAMqtt
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    : private HAMqttClientListener
+#endif
 {
 public:
-    static const uint16_t ReconnectInterval = 5000; // ms
+    static const uint16_t ReconnectMinInterval = 1000; // ms
+    static const uint16_t ReconnectMaxInterval = 60000; // ms
+    static const uint16_t DefaultConnectTimeout = 3; // seconds
+    static const uint16_t DefaultDiscoveryBudget = 0; // ms
+    static const uint8_t DefaultQueueMessagesBudget = 4;
+    static const uint8_t ProgmemChunkSize = 16; // bytes
+    static const uint16_t DefaultRetransmitTimeout = 5000; // ms
+    static const uint16_t DefaultQueueBytesBudget = 256;
+    static const uint16_t DefaultBirthMaxDelay = 5000; // ms
+    static const uint16_t DefaultTasksBudget = 2000; // us
+
+    enum ConnectionState {
+        StateDisconnected = 0,
+        StateSocketOpened,
+        StateSubscribing,
+        StateAnnouncing,
+        StateConnected
+    };
 
     HAMqtt(Client& netClient, HADevice& device);
     HAMqtt(const char* clientId, Client& netClient, HADevice& device);
+    ~HAMqtt();
 
     /**
      * Sets prefix for Home Assistant discovery.
@@ -30,27 +78,272 @@ public:
     inline const char* getDiscoveryPrefix() const
         { return _discoveryPrefix; }
 
+    /**
+     * Enables single wildcard subscription of all command topics that belong to the device.
+     * When enabled, the library subscribes "[discovery prefix]/+/[device ID]/+/cmd" topic
+     * once per connection instead of subscribing command topic of each device type.
+     * Topics that are outside of the device's namespace are still subscribed separately.
+     * The method needs to be called before `begin`.
+     *
+     * @param enabled
+     */
+    inline void setWildcardSubscription(bool enabled)
+        { _wildcardSubscription = enabled; }
+
     /**
      * Returns instance of the device assigned to the HAMqtt class.
      */
     inline HADevice const* getDevice() const
         { return (_hasDevice ? &_device : nullptr); }
 
+    /**
+     * Sets maximum time that the library waits for the broker's response (CONNACK)
+     * after sending the CONNECT packet. The timeout needs to be set before calling `begin`.
+     * Please note that opening of the TCP socket is handled by the network client
+     * and it may take longer than the given timeout.
+     *
+     * @param timeout Timeout in seconds.
+     */
+    inline void setConnectTimeout(uint16_t timeout)
+        { _connectTimeout = timeout; }
+
+    /**
+     * Sets limits of the queued messages that can be published in a single loop cycle
+     * once the connection with the broker is acquired.
+     * At least one message is published in each cycle regardless of the bytes limit.
+     *
+     * @param messages Maximum number of messages published in a single cycle.
+     * @param bytes Maximum number of bytes (topics and payloads) published in a single cycle.
+     */
+    inline void setQueueBudget(uint8_t messages, uint16_t bytes)
+        { _queueMessagesBudget = messages; _queueBytesBudget = bytes; }
+
+    /**
+     * Returns number of messages waiting in the publish queue.
+     */
+    inline uint8_t getQueueSize() const
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+        { return _publishQueue.size(); }
+#else
+        { return 0; }
+#endif
+
+    /**
+     * Sets time budget of the discovery (subscriptions and announcements of
+     * devices types) in a single loop cycle.
+     * At least one device type is processed in each cycle, so the default budget (0)
+     * processes exactly one device type per cycle.
+     *
+     * @param budget Time budget in milliseconds.
+     */
+    inline void setDiscoveryBudget(uint16_t budget)
+        { _discoveryBudget = budget; }
+
+    /**
+     * Returns true if all devices types were announced since the connection was acquired.
+     */
+    inline bool isDiscoveryCompleted() const
+        { return (_connectionState == StateConnected); }
+
+    /**
+     * Registers callback that will be called each time all devices types are announced.
+     *
+     * @param callback
+     */
+    inline void onDiscoveryCompleted(HAMQTT_DISCOVERY_CALLBACK)
+        { _discoveryCallback = callback; }
+
+    /**
+     * Forces all devices types to publish their configs again, even if they
+     * didn't change since the last announcement (see BaseDeviceType::getConfigHash).
+     * If the connection is acquired, the discovery starts over in the next loop cycle.
+     * It's useful when the broker lost its retained messages.
+     */
+    void forceDiscovery();
+
+    /**
+     * Sets maximum delay of the discovery triggered by the Home Assistant's birth message
+     * (`online` published to the [discovery prefix]/status topic).
+     * The actual delay is random within the range, so that all devices don't
+     * announce themselves at the same moment when Home Assistant starts.
+     *
+     * @param maxDelay Maximum delay in milliseconds.
+     */
+    inline void setBirthMessageDelay(uint16_t maxDelay)
+        { _birthMaxDelay = maxDelay; }
+
+    /**
+     * Sets QoS of messages published using `publish` method (states, availability, events).
+     * With QoS 1 the message is kept in the in-flight table until the broker acknowledges it
+     * and it's retransmitted if the acknowledgement doesn't arrive within the retransmit timeout.
+     * Discovery messages are always published with QoS 0, and so are messages that
+     * don't fit the in-flight slot (see ARDUINOHA_INFLIGHT_TOPIC_SIZE).
+     * QoS 1 requires ARDUINOHA_INFLIGHT_SIZE to be greater than 0 (it's 0 by default),
+     * otherwise messages are still published with QoS 0.
+     *
+     * @param qos 0 or 1
+     */
+    inline void setPublishQoS(uint8_t qos)
+        { _publishQoS = (qos > 0 && ARDUINOHA_INFLIGHT_SIZE > 0 ? 1 : 0); }
+
+    /**
+     * Sets time after which unacknowledged QoS 1 message is retransmitted.
+     *
+     * @param timeout Timeout in milliseconds.
+     */
+    inline void setRetransmitTimeout(uint16_t timeout)
+        { _retransmitTimeout = timeout; }
+
+    /**
+     * Returns number of QoS 1 messages waiting for the acknowledgement.
+     */
+    uint8_t getInFlightNb() const;
+
+    /**
+     * Returns number of QoS 1 messages retransmitted since the start.
+     */
+    inline uint32_t getRetransmitsNb() const
+        { return _retransmitsNb; }
+
+    /**
+     * Returns average time between the first transmission of QoS 1 message
+     * and its acknowledgement (in milliseconds).
+     */
+    inline uint32_t getAverageAckLatency() const
+        { return (_acksNb > 0 ? (_ackLatencySum / _acksNb) : 0); }
+
+    /**
+     * Schedules the callback to be called from within the `loop` method.
+     * Tasks are executed after the network housekeeping, in order of their deadlines.
+     * Returns false if there is no free slot for the task (see ARDUINOHA_SCHEDULER_SIZE).
+     *
+     * @param callback Function that will be called.
+     * @param delay Delay of the first call in milliseconds.
+     * @param interval Interval between calls in milliseconds (0 makes one-shot task).
+     * @param context Pointer that will be passed to the callback.
+     */
+    bool schedule(
+        HASCHEDULER_CALLBACK,
+        uint32_t delay,
+        uint32_t interval = 0,
+        void* context = nullptr
+    );
+
+    /**
+     * Removes the scheduled task with the given callback and context.
+     *
+     * @param callback
+     * @param context
+     */
+    bool cancel(HASCHEDULER_CALLBACK, void* context = nullptr);
+
+    /**
+     * Sets time budget of the scheduled tasks in a single loop cycle.
+     * At least one due task is executed in each cycle regardless of the budget.
+     *
+     * @param budget Time budget in microseconds.
+     */
+    inline void setTasksBudget(uint32_t budget)
+        { _tasksBudget = budget; }
+
+    /**
+     * Enables deferred publishing of states. When enabled, setters of devices types
+     * (e.g. HASensor::setValue, HASwitch::setState) only mark the device type as dirty
+     * and all pending states are published back-to-back by `flush`, which is called
+     * at the end of each `loop`. Only the latest state of each device type is published.
+     * Deferred publishing requires ARDUINOHA_DIRTY_SET_SIZE to be greater than 0.
+     *
+     * @param enabled
+     */
+    inline void setDeferredPublishing(bool enabled)
+        { _deferredPublishing = enabled; }
+
+    inline bool isDeferredPublishing() const
+        { return _deferredPublishing; }
+
+    /**
+     * Publishes states of all devices types marked as dirty in a single pass
+     * through the write buffer (see ARDUINOHA_WRITE_BUFFER_SIZE).
+     * Devices types whose state couldn't be published while connected stay dirty
+     * and are published by the next flush.
+     * Returns false if the buffered data couldn't be written.
+     */
+    bool flush();
+
+    /**
+     * Marks the device type as dirty, so its state will be published by `flush`.
+     * Returns false if the state needs to be published right away
+     * (deferred publishing is disabled or the device type is beyond the dirty set).
+     *
+     * @param deviceType
+     */
+    bool markDirty(BaseDeviceType* deviceType);
+
+    /**
+     * Returns number of messages published since the start.
+     */
+    inline uint32_t getPublishedNb() const
+        { return _publishedNb; }
+
+    /**
+     * Returns number of messages that couldn't be published nor queued.
+     */
+    inline uint32_t getFailedPublishesNb() const
+        { return _failedPublishesNb; }
+
+    /**
+     * Returns number of received messages that were dropped because their topic
+     * is longer than any subscribed topic. Used only by the built-in MQTT client,
+     * PubSubClient drops messages that don't fit its buffer without notice.
+     */
+    inline uint32_t getDroppedMessagesNb() const
+#if defined(ARDUINOHA_NATIVE_MQTT)
+        { return _mqtt.getSkippedMessagesNb(); }
+#else
+        { return 0; }
+#endif
+
+    /**
+     * Returns number of bytes written to the network client since the start.
+     */
+    inline uint32_t getBytesSent() const
+        { return _client.getBytesWritten(); }
+
+    /**
+     * Returns number of connections with the broker acquired after the first one.
+     */
+    inline uint32_t getReconnectsNb() const
+        { return (_connectionsNb > 0 ? _connectionsNb - 1 : 0); }
+
+    /**
+     * Returns current state of the connection with the MQTT broker.
+     */
+    inline ConnectionState getConnectionState() const
+        { return _connectionState; }
+
     /**
      * Sets parameters of the connection to the MQTT broker.
      * The library will try to connect to the broker in first loop cycle.
      * Please note that the library automatically reconnects to the broker if connection is lost.
      *
+     * With persistent session the broker keeps subscriptions and QoS 1 messages
+     * of the device between connections. If the broker confirms that the session
+     * is present, topics are not subscribed again after reconnect. The first connection
+     * after boot always subscribes all topics, as the session may come from a firmware
+     * with different entities.
+     *
      * @param serverIp IP address of the MQTT broker.
      * @param serverPort Port of the MQTT broker.
      * @param username Username for authentication.
      * @param password Password for authentication.
+     * @param persistentSession Determines whether the session should be kept by the broker.
      */
     bool begin(
         const IPAddress& serverIp,
         const uint16_t& serverPort = 1883,
         const char* username = nullptr,
-        const char* password = nullptr
+        const char* password = nullptr,
+        bool persistentSession = false
     );
 
     /**
@@ -71,9 +364,35 @@ public:
 
     /**
      * ArduinoHA's ticker.
+     * Connection with the broker is established in steps (socket, handshake,
+     * subscriptions, announcements) and each call of the method advances
+     * it by a single step, so the loop is never blocked by the whole procedure.
      */
     void loop();
 
+    /**
+     * Returns number of milliseconds until the library needs the next `loop` call.
+     * It takes into account keepalive of the connection, reconnect backoff,
+     * pending messages, retransmissions, scheduled tasks and deferred states of
+     * devices types, so the application may sleep for the given time.
+     * Returns 0 if there is pending work, e.g. the discovery is in progress.
+     * Please note that incoming messages aren't predictable, so the application
+     * needs to wake up on network activity as well.
+     */
+    uint32_t nextWakeupIn();
+
+#if defined(ARDUINOHA_LOOP_STATS)
+    /**
+     * Returns latency statistics of the loop's phases.
+     * Available only if ARDUINOHA_LOOP_STATS is defined.
+     */
+    inline const HALoopStats& getLoopStats() const
+        { return _loopStats; }
+
+    inline void resetLoopStats()
+        { _loopStats.reset(); }
+#endif
+
     /**
      * Returns true if connection to the MQTT broker is established.
      */
@@ -82,7 +401,7 @@ public:
     /**
      * Adds a new device's type to the MQTT.
      * Each time the connection with MQTT broker is acquired, the HAMqtt class
-     * calls "onMqttConnected" method in all devices' types instances.
+     * calls "onMqttSubscribe" and "onMqttConnected" methods in all devices' types instances.
      *
      * @param deviceType Instance of the device's type (eg. HATriggers).
      */
@@ -90,8 +409,11 @@ public:
 
     /**
      * Publishes MQTT message with given topic and payload.
-     * Message won't be published if connection with MQTT broker is not established.
-     * In this case method returns false.
+     * If connection with MQTT broker is not established the message is added
+     * to the publish queue and it will be published once the connection is acquired.
+     * While the queue isn't empty, new messages are queued behind the queued ones,
+     * so the messages are published in order.
+     * Method returns false if the message couldn't be published nor queued.
      *
      * @param topic Topic to publish.
      * @param payload Payload to publish (it may be empty const char).
@@ -99,25 +421,62 @@ public:
      */
     bool publish(const char* topic, const char* payload, bool retained = false);
 
+    /**
+     * Begins publishing of the MQTT message with given topic.
+     * Header, topic and payload of the message are combined in the write buffer
+     * (see ARDUINOHA_WRITE_BUFFER_SIZE) until `endPublish` is called.
+     *
+     * @param topic Topic to publish.
+     * @param payloadLength Length of the payload that will be written.
+     * @param retained Determines whether message should be retained.
+     */
     bool beginPublish(const char* topic, uint16_t payloadLength, bool retained = false);
     bool writePayload(const char* data, uint16_t length);
+
+    /**
+     * Writes null-terminated string stored in the flash memory to the payload.
+     * The string is copied to the client through a small fixed-size buffer.
+     *
+     * @param src String stored in the flash memory (PROGMEM).
+     */
     bool writePayload_P(const char* src);
     bool endPublish();
 
+    /**
+     * Begins calculation of the fingerprint of the message with given topic.
+     * Until `endFingerprint` is called, the payload written with `writePayload`
+     * and `writePayload_P` is hashed instead of being sent to the broker.
+     * Topics of messages started with `beginPublish` in the meantime are hashed as well,
+     * so the fingerprint may cover multiple messages.
+     *
+     * @param topic Topic of the message (it may be nullptr).
+     */
+    void beginFingerprint(const char* topic);
+
+    /**
+     * Ends calculation of the fingerprint and returns it.
+     */
+    uint32_t endFingerprint();
+
     /**
      * Subscribes to the given topic.
-     * Whenever a new message is received the onMqttMessage callback in all
-     * devices types is called.
+     * Whenever a new message is received on the topic the onMqttMessage callback
+     * of the owner is called. If the owner is not set, the message is passed to
+     * all devices types.
      *
      * Please note that you need to subscribe topic each time the connection
-     * with the broker is acquired.
+     * with the broker is acquired. On reconnects within the same boot the topic
+     * is registered only locally if the broker kept the persistent session.
      *
      * @param topic Topic to subscribe
+     * @param owner Device type that handles messages of the topic.
      */
-    bool subscribe(const char* topic);
+    bool subscribe(const char* topic, BaseDeviceType* owner = nullptr);
 
     /**
      * Processes MQTT message received from the broker (subscription).
+     * Please note that the streaming handlers of devices types
+     * (see BaseDeviceType::onMqttMessageBegin) are not called by this method.
      *
      * @param topic Topic of the message.
      * @param payload Content of the message.
@@ -125,31 +484,299 @@ public:
      */
     void processMessage(char* topic, uint8_t* payload, uint16_t length);
 
+protected:
+    /**
+     * Initializes HAMqtt with the storage provided by the caller.
+     * The storage is never reallocated, so the number of devices types and
+     * subscriptions is limited to the given capacity, and the built-in MQTT client
+     * receives messages whose topic fits the given buffer (nullptr for PubSubClient).
+     * See HAMqttStatic for the heap-free variant of the class.
+     */
+    HAMqtt(
+        Client& netClient,
+        HADevice& device,
+        BaseDeviceType** devicesTypes,
+        uint16_t maxDevicesTypes,
+        HASubscription* subscriptions,
+        uint16_t maxSubscriptions,
+        char* receiveTopic,
+        uint16_t receiveTopicSize
+    );
+
 private:
     /**
-     * Attempts to connect to the MQTT broker.
+     * Calls loop of the MQTT client and routes received messages to this instance.
+     * Returns false if the connection with the broker is lost.
+     */
+    bool loopClient();
+
+    /**
+     * Advances the connection with the MQTT broker by a single step.
      * The method uses properties passed to the "begin" method.
      */
     void connectToServer();
 
+    /**
+     * Opens TCP socket to the broker if the reconnect interval has elapsed.
+     */
+    void openSocket();
+
+    /**
+     * Sends CONNECT packet through the opened socket and waits for the CONNACK.
+     * The built-in client receives the CONNACK in the next loop cycles.
+     */
+    void performHandshake();
+
+    /**
+     * Sends CONNECT packet through the opened socket.
+     */
+    void sendConnect();
+
     /**
      * This method is called each time the connection with MQTT broker is acquired.
      */
     void onConnected();
 
+    /**
+     * Calls "onMqttSubscribe" or "onMqttConnected" methods of the next devices types
+     * within the discovery budget.
+     */
+    void processDiscovery();
+
+    /**
+     * Subscribes wildcard topic that matches all command topics of the device.
+     */
+    void subscribeCommandWildcard();
+
+    /**
+     * Returns true if the topic matches "[discovery prefix]/+/[device ID]/+/cmd" pattern.
+     */
+    bool isDeviceCommandTopic(const char* topic) const;
+
+    /**
+     * Finds range [first, last) of the subscriptions registry that matches the topic.
+     * Returns true if the message needs to be passed to all devices types.
+     */
+    bool findReceivers(const char* topic, uint16_t* first, uint16_t* last) const;
+
+    /**
+     * Passes the beginning of the received message to the streaming handlers
+     * of devices types that receive messages of the topic.
+     */
+    void beginMessage(const char* topic, uint32_t length);
+
+    /**
+     * Passes chunk of the received message's payload to the streaming handlers.
+     */
+    void streamMessage(const uint8_t* data, uint16_t length);
+
+    /**
+     * Passes the end of the received message to the streaming handlers.
+     */
+    void endMessage();
+
+    /**
+     * Adds the topic to the subscriptions registry.
+     * The registry is sorted by hash and length of the topic.
+     */
+    void registerSubscription(const char* topic, BaseDeviceType* owner);
+
+    /**
+     * Grows buffer of the received topic, so the built-in MQTT client
+     * receives messages of topics with the given length.
+     * Messages with longer topics can't match any subscription.
+     *
+     * @param length Length of the topic (excluding null terminator).
+     */
+    void reserveReceiveTopic(uint16_t length);
+
+    /**
+     * Returns index of the first subscription with given hash and length
+     * (or index where it would be inserted).
+     */
+    uint16_t findSubscription(uint16_t hash, uint16_t length) const;
+
+    /**
+     * Publishes messages from the queue within the configured budget.
+     */
+    void processPublishQueue();
+
+    /**
+     * Publishes MQTT message without checking the queue.
+     */
+    bool publishMessage(const char* topic, const char* payload, bool retained);
+
+    /**
+     * Publishes message with QoS 1 and adds it to the in-flight table.
+     * Returns false if the in-flight table is full.
+     */
+    bool publishQoS1Message(const char* topic, const char* payload, bool retained);
+
+    /**
+     * Writes QoS 1 PUBLISH packet of the in-flight message to the client.
+     */
+    bool writeQoS1Packet(const HAInFlightMessage* message, bool duplicate);
+
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+    /**
+     * Reads PUBACK packets waiting at the beginning of the client's stream.
+     * PubSubClient ignores them, so they need to be consumed before its loop.
+     */
+    void processAcknowledgements();
+#endif
+
+    /**
+     * Removes acknowledged QoS 1 message from the in-flight table.
+     *
+     * @param packetId
+     */
+    void acknowledgeMessage(uint16_t packetId);
+
+#if !defined(ARDUINOHA_NATIVE_MQTT)
+    /**
+     * PubSubClient's callback. PubSubClient receives the whole message
+     * before calling it, so the streaming handlers get a single chunk.
+     */
+    static void onMessageReceived(char* topic, uint8_t* payload, unsigned int length);
+#endif
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    virtual void onMessageBegin(char* topic, uint32_t length) override;
+    virtual void onMessageData(const uint8_t* data, uint16_t length) override;
+    virtual void onMessageEnd() override;
+    virtual void onPubAck(uint16_t packetId) override;
+#endif
+
+    /**
+     * Retransmits QoS 1 messages that weren't acknowledged within the timeout.
+     */
+    void processRetransmissions();
+
+    /**
+     * Maintains connection with the broker and processes its messages.
+     */
+    void processNetwork();
+
+    /**
+     * Returns number of milliseconds until the network housekeeping needs to run.
+     */
+    uint32_t nextNetworkWakeupIn();
+
+    /**
+     * Schedules next connection attempt using exponential backoff with jitter.
+     */
+    void scheduleReconnect();
+
+    /**
+     * Subscribes to the topic of Home Assistant's birth and last will messages.
+     */
+    void subscribeStatus();
+
+    /**
+     * Returns true if the given topic is [discovery prefix]/status.
+     *
+     * @param topic
+     */
+    bool isStatusTopic(const char* topic) const;
+
+    /**
+     * Starts the discovery scheduled by the birth message once its delay passes.
+     */
+    void processScheduledDiscovery();
+
+    /**
+     * Writes part of the payload to the client (or to the fingerprint).
+     */
+    bool writeRaw(const uint8_t* data, uint16_t length);
+
     Client& _netClient;
     HADevice& _device;
     bool _hasDevice;
     bool _initialized;
     const char* _discoveryPrefix;
-    PubSubClient* _mqtt;
-    IPAddress* _serverIp;
+    HANetClient _client;
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    HAMqttClient _mqtt;
+    char* _receiveTopic;
+    uint16_t _receiveTopicSize;
+    uint16_t _receiveLength;
+    bool _receiveOverflow;
+    uint8_t _receiveBuffer[ARDUINOHA_RECEIVE_PAYLOAD_SIZE];
+#else
+    PubSubClient _mqtt;
+#endif
+    IPAddress _serverIp;
     uint16_t _serverPort;
     const char* _username;
     const char* _password;
+    bool _persistentSession;
+    bool _sessionPresent;
+    bool _sessionSubscribed;
+    bool _subscriptionsKept;
+    uint16_t _connectTimeout;
+    ConnectionState _connectionState;
     uint32_t _lastConnectionAttemptAt;
-    uint8_t _devicesTypesNb;
+    uint32_t _reconnectInterval;
+    uint32_t _reconnectBackoff;
+    uint16_t _nextDeviceTypeIndex;
+    uint16_t _discoveryBudget;
+    void (*_discoveryCallback)();
+    uint8_t _queueMessagesBudget;
+    uint16_t _queueBytesBudget;
+    uint16_t _devicesTypesNb;
+    uint16_t _subscriptionsNb;
+    bool _hasUnownedSubscriptions;
+    bool _wildcardSubscription;
+
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+    HAPublishQueue _publishQueue;
+#endif
+
+    uint8_t _publishQoS;
+    uint16_t _retransmitTimeout;
+    uint16_t _nextPacketId;
+    uint32_t _retransmitsNb;
+    uint32_t _acksNb;
+    uint32_t _ackLatencySum;
+    bool _fingerprinting;
+    uint32_t _fingerprint;
+    uint16_t _birthMaxDelay;
+    bool _discoveryScheduled;
+    uint32_t _discoveryScheduledAt;
+    uint16_t _discoveryDelay;
+    uint32_t _tasksBudget;
+    uint32_t _publishedNb;
+    uint32_t _failedPublishesNb;
+    uint32_t _connectionsNb;
+    bool _streaming;
+    bool _streamBroadcast;
+    uint16_t _streamFirst;
+    uint16_t _streamLast;
+    bool _deferredPublishing;
+    bool _flushStalled;
+
+#if ARDUINOHA_DIRTY_SET_SIZE > 0
+    uint8_t _dirtySet[(ARDUINOHA_DIRTY_SET_SIZE + 7) / 8];
+#endif
+
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+    HAScheduler _scheduler;
+#endif
+
+#if defined(ARDUINOHA_LOOP_STATS)
+    HALoopStats _loopStats;
+#endif
+
+#if ARDUINOHA_INFLIGHT_SIZE > 0
+    HAInFlightMessage _inFlight[ARDUINOHA_INFLIGHT_SIZE];
+#endif
+
+    const bool _staticStorage;
+    uint16_t _devicesTypesCapacity;
     BaseDeviceType** _devicesTypes;
+    uint16_t _subscriptionsCapacity;
+    HASubscription* _subscriptions;
 };
 
 #endif
@@ -0,0 +1,557 @@
+#include <Arduino.h>
+
+#include "HAMqttClient.h"
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+
+// MQTT 3.1.1 control packets
+#define HAMQTTCLIENT_CONNECT 0x10
+#define HAMQTTCLIENT_CONNACK 0x20
+#define HAMQTTCLIENT_PUBLISH 0x30
+#define HAMQTTCLIENT_PUBACK 0x40
+#define HAMQTTCLIENT_SUBSCRIBE 0x82
+#define HAMQTTCLIENT_PINGREQ 0xC0
+#define HAMQTTCLIENT_DISCONNECT 0xE0
+
+HAMqttClient::HAMqttClient(Client& client) :
+    _client(client),
+    _listener(nullptr),
+    _state(StateDisconnected),
+    _socketTimeout(15),
+    _nextPacketId(1),
+    _lastOutAt(0),
+    _lastInAt(0),
+    _pingOutstanding(false),
+    _parserState(ParseHeader),
+    _header(0),
+    _remainingLength(0),
+    _lengthShift(0),
+    _fieldLength(0),
+    _fieldRead(0),
+    _packetId(0),
+    _skipMessage(false),
+    _skippedMessagesNb(0),
+    _topic(nullptr),
+    _topicSize(0)
+{
+
+}
+
+bool HAMqttClient::connect(
+    const char* id,
+    const char* user,
+    const char* pass,
+    const char* willTopic,
+    uint8_t willQos,
+    bool willRetain,
+    const char* willMessage,
+    bool cleanSession
+)
+{
+    static const uint8_t ProtocolHeader[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04};
+
+    uint8_t flags = (cleanSession ? 0x02 : 0x00);
+    uint32_t remainingLength = sizeof(ProtocolHeader) + 3 + 2 + strlen(id); // with flags and keepalive
+
+    if (willTopic != nullptr) {
+        flags |= 0x04 | (willQos << 3) | (willRetain ? 0x20 : 0x00);
+        remainingLength += 2 + strlen(willTopic) + 2 + strlen(willMessage);
+    }
+
+    if (user != nullptr) {
+        flags |= 0x80;
+        remainingLength += 2 + strlen(user);
+
+        if (pass != nullptr) {
+            flags |= 0x40;
+            remainingLength += 2 + strlen(pass);
+        }
+    }
+
+    const uint8_t variableHeader[3] = {
+        flags,
+        (uint8_t)(KeepAlive >> 8),
+        (uint8_t)(KeepAlive & 0xFF)
+    };
+
+    resetParser();
+    _pingOutstanding = false;
+
+    bool result = (
+        writeHeader(HAMQTTCLIENT_CONNECT, remainingLength) &&
+        write(ProtocolHeader, sizeof(ProtocolHeader)) == sizeof(ProtocolHeader) &&
+        write(variableHeader, sizeof(variableHeader)) == sizeof(variableHeader) &&
+        writeString(id)
+    );
+
+    if (result && willTopic != nullptr) {
+        result = (writeString(willTopic) && writeString(willMessage));
+    }
+
+    if (result && user != nullptr) {
+        result = writeString(user);
+
+        if (result && pass != nullptr) {
+            result = writeString(pass);
+        }
+    }
+
+    if (!result) {
+        close();
+        return false;
+    }
+
+    // the socket timeout is counted from the CONNECT packet
+    _lastInAt = _lastOutAt;
+    _state = StateConnecting;
+    return true;
+}
+
+bool HAMqttClient::connected()
+{
+    if (_state != StateDisconnected && !_client.connected()) {
+        close();
+    }
+
+    return (_state == StateConnected);
+}
+
+void HAMqttClient::disconnect()
+{
+    if (_state == StateDisconnected) {
+        return;
+    }
+
+    const uint8_t packet[2] = {HAMQTTCLIENT_DISCONNECT, 0x00};
+    write(packet, sizeof(packet));
+    close();
+}
+
+bool HAMqttClient::loop()
+{
+    if (_state == StateDisconnected) {
+        return false;
+    }
+
+    if (!_client.connected()) {
+        close();
+        return false;
+    }
+
+    const uint32_t& now = ARDUINOHA_MILLIS();
+
+    if (_state == StateConnecting) {
+        if ((now - _lastOutAt) >= (_socketTimeout * 1000UL)) {
+#if defined(ARDUINOHA_DEBUG)
+            Serial.println(F("CONNACK hasn't been received within the timeout"));
+#endif
+
+            close();
+            return false;
+        }
+    } else if ((now - _lastInAt) >= (KeepAlive * 1000UL) ||
+            (now - _lastOutAt) >= (KeepAlive * 1000UL)) {
+        if (_pingOutstanding) {
+            close(); // the broker didn't respond to the previous PINGREQ
+            return false;
+        }
+
+        const uint8_t packet[2] = {HAMQTTCLIENT_PINGREQ, 0x00};
+        write(packet, sizeof(packet));
+
+        _lastInAt = now;
+        _pingOutstanding = true;
+    }
+
+    if (!readIncoming()) {
+#if defined(ARDUINOHA_DEBUG)
+        Serial.println(F("Received malformed MQTT packet"));
+#endif
+
+        close();
+        return false;
+    }
+
+    return (_state == StateConnected);
+}
+
+bool HAMqttClient::beginPublish(
+    const char* topic,
+    uint32_t payloadLength,
+    bool retained
+)
+{
+    if (!connected()) {
+        return false;
+    }
+
+    const uint16_t& topicLength = strlen(topic);
+    return (
+        writeHeader(
+            HAMQTTCLIENT_PUBLISH | (retained ? 0x01 : 0x00),
+            2 + topicLength + payloadLength
+        ) &&
+        writeString(topic)
+    );
+}
+
+size_t HAMqttClient::write(const uint8_t* data, size_t length)
+{
+    _lastOutAt = ARDUINOHA_MILLIS();
+    return _client.write(data, length);
+}
+
+bool HAMqttClient::endPublish()
+{
+    return connected();
+}
+
+bool HAMqttClient::subscribe(const char* topic, uint8_t qos)
+{
+    if (!connected()) {
+        return false;
+    }
+
+    const uint8_t packetId[2] = {
+        (uint8_t)(_nextPacketId >> 8),
+        (uint8_t)(_nextPacketId & 0xFF)
+    };
+
+    if (++_nextPacketId == 0) {
+        _nextPacketId = 1;
+    }
+
+    return (
+        writeHeader(HAMQTTCLIENT_SUBSCRIBE, 2 + 2 + strlen(topic) + 1) &&
+        write(packetId, sizeof(packetId)) == sizeof(packetId) &&
+        writeString(topic) &&
+        write(&qos, 1) == 1
+    );
+}
+
+bool HAMqttClient::writeHeader(uint8_t header, uint32_t remainingLength)
+{
+    uint8_t data[5]; // packet type + up to 4 bytes of the remaining length
+    uint8_t length = 0;
+
+    data[length++] = header;
+
+    do {
+        uint8_t digit = remainingLength % 128;
+        remainingLength /= 128;
+
+        if (remainingLength > 0) {
+            digit |= 0x80;
+        }
+
+        data[length++] = digit;
+    } while (remainingLength > 0 && length < sizeof(data));
+
+    return (write(data, length) == length);
+}
+
+bool HAMqttClient::writeString(const char* str)
+{
+    const uint16_t& length = strlen(str);
+    const uint8_t prefix[2] = {
+        (uint8_t)(length >> 8),
+        (uint8_t)(length & 0xFF)
+    };
+
+    return (
+        write(prefix, sizeof(prefix)) == sizeof(prefix) &&
+        (length == 0 || write((const uint8_t*)(str), length) == length)
+    );
+}
+
+void HAMqttClient::resetParser()
+{
+    _parserState = ParseHeader;
+}
+
+int HAMqttClient::readBytes(uint8_t* data, uint16_t length)
+{
+    const int& available = _client.available();
+    if (available <= 0) {
+        return 0;
+    }
+
+    if ((uint16_t)(available) < length) {
+        length = available;
+    }
+
+    const int& result = _client.read(data, length);
+    if (result > 0) {
+        _lastInAt = ARDUINOHA_MILLIS();
+    }
+
+    return result;
+}
+
+bool HAMqttClient::readIncoming()
+{
+    uint8_t chunk[ReadChunkSize];
+
+    // a single packet is processed per call, the same as in PubSubClient
+    for (;;) {
+        switch (_parserState) {
+            case ParseHeader:
+            case ParseLength:
+            case ParseTopicLength:
+            case ParsePacketId: {
+                uint8_t byte;
+                if (readBytes(&byte, 1) <= 0) {
+                    return true;
+                }
+
+                if (!parseByte(byte)) {
+                    return false;
+                }
+
+                break;
+            }
+
+            case ParseTopic: {
+                if (_fieldRead == _fieldLength) {
+                    if (!_skipMessage) {
+                        _topic[_fieldLength] = '\0';
+                    }
+
+                    if ((_header & 0x06) != 0) { // QoS > 0
+                        _fieldRead = 0;
+                        _packetId = 0;
+                        _parserState = ParsePacketId;
+                    } else {
+                        beginPayload();
+                    }
+
+                    break;
+                }
+
+                uint16_t length = _fieldLength - _fieldRead;
+                if (_skipMessage && length > ReadChunkSize) {
+                    length = ReadChunkSize;
+                }
+
+                const int& read = readBytes(
+                    _skipMessage ? chunk : (uint8_t*)(&_topic[_fieldRead]),
+                    length
+                );
+                if (read <= 0) {
+                    return true;
+                }
+
+                _fieldRead += read;
+                _remainingLength -= read;
+                break;
+            }
+
+            case ParsePayload: {
+                if (_remainingLength == 0) {
+                    endPayload();
+                    return true;
+                }
+
+                const int& read = readBytes(
+                    chunk,
+                    _remainingLength < ReadChunkSize ? _remainingLength : ReadChunkSize
+                );
+                if (read <= 0) {
+                    return true;
+                }
+
+                _remainingLength -= read;
+
+                if (!_skipMessage && _listener != nullptr) {
+                    _listener->onMessageData(chunk, read);
+                }
+
+                break;
+            }
+
+            case ParseBody: {
+                if (_remainingLength == 0) {
+                    resetParser();
+                    processPacket();
+                    return true;
+                }
+
+                const int& read = readBytes(
+                    chunk,
+                    _remainingLength < ReadChunkSize ? _remainingLength : ReadChunkSize
+                );
+                if (read <= 0) {
+                    return true;
+                }
+
+                // only the beginning of the body is meaningful for supported packets
+                for (int i = 0; i < read && _fieldRead < sizeof(_body); i++) {
+                    _body[_fieldRead++] = chunk[i];
+                }
+
+                _remainingLength -= read;
+                break;
+            }
+        }
+    }
+}
+
+bool HAMqttClient::parseByte(uint8_t byte)
+{
+    switch (_parserState) {
+        case ParseHeader:
+            _header = byte;
+            _remainingLength = 0;
+            _lengthShift = 0;
+            _parserState = ParseLength;
+            return true;
+
+        case ParseLength:
+            if (_lengthShift > 21) {
+                return false; // the remaining length has up to 4 bytes
+            }
+
+            _remainingLength |= (uint32_t)(byte & 0x7F) << _lengthShift;
+            _lengthShift += 7;
+
+            if ((byte & 0x80) == 0) {
+                beginPacket();
+            }
+
+            return true;
+
+        case ParseTopicLength:
+            if (_remainingLength == 0) {
+                return false;
+            }
+
+            _fieldLength = (_fieldLength << 8) | byte;
+            _remainingLength--;
+
+            if (++_fieldRead == 2) {
+                if (_fieldLength > _remainingLength) {
+                    return false;
+                }
+
+                _skipMessage = (_topic == nullptr || _fieldLength >= _topicSize);
+
+                if (_skipMessage) {
+#if defined(ARDUINOHA_DEBUG)
+                    Serial.println(F("Skipping message. Topic is too long."));
+#endif
+
+                    _skippedMessagesNb++;
+                }
+
+                _fieldRead = 0;
+                _parserState = ParseTopic;
+            }
+
+            return true;
+
+        case ParsePacketId:
+            if (_remainingLength == 0) {
+                return false;
+            }
+
+            _packetId = (_packetId << 8) | byte;
+            _remainingLength--;
+
+            if (++_fieldRead == 2) {
+                beginPayload();
+            }
+
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void HAMqttClient::beginPacket()
+{
+    // any packet proves that the broker is alive
+    _pingOutstanding = false;
+    _fieldLength = 0;
+    _fieldRead = 0;
+
+    if ((_header & 0xF0) == HAMQTTCLIENT_PUBLISH) {
+        _parserState = ParseTopicLength;
+    } else {
+        _parserState = ParseBody;
+    }
+}
+
+void HAMqttClient::beginPayload()
+{
+    _parserState = ParsePayload;
+
+    if (!_skipMessage && _listener != nullptr) {
+        _listener->onMessageBegin(_topic, _remainingLength);
+    }
+}
+
+void HAMqttClient::endPayload()
+{
+    resetParser();
+
+    if (!_skipMessage && _listener != nullptr) {
+        _listener->onMessageEnd();
+    }
+
+    // QoS 2 is never requested in subscriptions
+    if ((_header & 0x06) == 0x02) {
+        const uint8_t packet[4] = {
+            HAMQTTCLIENT_PUBACK,
+            0x02,
+            (uint8_t)(_packetId >> 8),
+            (uint8_t)(_packetId & 0xFF)
+        };
+
+        write(packet, sizeof(packet));
+    }
+}
+
+void HAMqttClient::processPacket()
+{
+    switch (_header & 0xF0) {
+        case HAMQTTCLIENT_CONNACK:
+            if (_state != StateConnecting) {
+                break;
+            }
+
+            if (_fieldRead < 2 || _body[1] != 0x00) {
+#if defined(ARDUINOHA_DEBUG)
+                Serial.print(F("Connection refused by the broker. Code: "));
+                Serial.print(_fieldRead < 2 ? -1 : _body[1]);
+                Serial.println();
+#endif
+
+                close();
+                break;
+            }
+
+            _state = StateConnected;
+            break;
+
+        case HAMQTTCLIENT_PUBACK:
+            if (_fieldRead >= 2 && _listener != nullptr) {
+                _listener->onPubAck((_body[0] << 8) | _body[1]);
+            }
+
+            break;
+
+        default:
+            break; // SUBACK, PINGRESP
+    }
+}
+
+void HAMqttClient::close()
+{
+    _client.stop();
+    _state = StateDisconnected;
+    _pingOutstanding = false;
+    resetParser();
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef AHA_HAMQTTCLIENT_H
+#define AHA_HAMQTTCLIENT_H
+
+#include <Client.h>
+
+#include "ArduinoHADefines.h"
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+
+/**
+ * Receiver of packets parsed by HAMqttClient.
+ */
+class HAMqttClientListener
+{
+public:
+    /**
+     * Called when topic of the incoming PUBLISH packet is parsed.
+     *
+     * @param topic Null-terminated topic (valid until `onMessageEnd`).
+     * @param length Total length of the payload.
+     */
+    virtual void onMessageBegin(char* topic, uint32_t length) = 0;
+
+    /**
+     * Called for each chunk of the payload as soon as it's received.
+     *
+     * @param data
+     * @param length
+     */
+    virtual void onMessageData(const uint8_t* data, uint16_t length) = 0;
+
+    /**
+     * Called when the whole payload has been received.
+     */
+    virtual void onMessageEnd() = 0;
+
+    /**
+     * Called when PUBACK packet is received.
+     *
+     * @param packetId
+     */
+    virtual void onPubAck(uint16_t packetId) = 0;
+};
+
+/**
+ * Minimal MQTT 3.1.1 client used instead of PubSubClient if ARDUINOHA_NATIVE_MQTT is defined.
+ * Outgoing packets are encoded straight to the network client, so their size isn't limited
+ * by any buffer. Incoming packets are parsed incrementally from the bytes that are available,
+ * so the loop never waits for the rest of the packet, and payloads are passed to
+ * the listener in chunks. Only the topic of the incoming message is buffered
+ * in the buffer provided by the owner (see `setTopicBuffer`); messages with longer
+ * topics are skipped and counted.
+ */
+class HAMqttClient
+{
+public:
+    static const uint16_t KeepAlive = 15; // seconds
+    static const uint8_t ReadChunkSize = 32; // bytes
+
+    HAMqttClient(Client& client);
+
+    inline void setListener(HAMqttClientListener* listener)
+        { _listener = listener; }
+
+    /**
+     * Sets buffer of the incoming message's topic. The buffer may be replaced
+     * at any time as long as its content is preserved (e.g. by realloc).
+     *
+     * @param buffer
+     * @param size Size of the buffer (including null terminator).
+     */
+    inline void setTopicBuffer(char* buffer, uint16_t size)
+        { _topic = buffer; _topicSize = size; }
+
+    /**
+     * Returns number of incoming messages skipped because their topic
+     * didn't fit the topic's buffer.
+     */
+    inline uint32_t getSkippedMessagesNb() const
+        { return _skippedMessagesNb; }
+
+    /**
+     * Sets maximum time of waiting for the CONNACK packet.
+     *
+     * @param timeout Timeout in seconds.
+     */
+    inline void setSocketTimeout(uint16_t timeout)
+        { _socketTimeout = timeout; }
+
+    /**
+     * Sends the CONNECT packet through the socket that's already opened.
+     * The method doesn't wait for the broker's response. The connection is
+     * acquired once `connected` returns true, and it's failed when
+     * `isConnecting` returns false before that.
+     */
+    bool connect(
+        const char* id,
+        const char* user,
+        const char* pass,
+        const char* willTopic,
+        uint8_t willQos,
+        bool willRetain,
+        const char* willMessage,
+        bool cleanSession
+    );
+
+    /**
+     * Returns true if the CONNECT packet was sent and the CONNACK packet is awaited.
+     */
+    inline bool isConnecting() const
+        { return (_state == StateConnecting); }
+
+    bool connected();
+    void disconnect();
+
+    /**
+     * Processes incoming packets and maintains keepalive of the connection.
+     * Returns true if the connection is acquired.
+     */
+    bool loop();
+
+    bool beginPublish(const char* topic, uint32_t payloadLength, bool retained);
+    size_t write(const uint8_t* data, size_t length);
+    bool endPublish();
+    bool subscribe(const char* topic, uint8_t qos);
+
+private:
+    enum State {
+        StateDisconnected = 0,
+        StateConnecting,
+        StateConnected
+    };
+
+    enum ParserState {
+        ParseHeader = 0,
+        ParseLength,
+        ParseTopicLength,
+        ParseTopic,
+        ParsePacketId,
+        ParsePayload,
+        ParseBody
+    };
+
+    bool writeHeader(uint8_t header, uint32_t remainingLength);
+    bool writeString(const char* str);
+    void resetParser();
+    int readBytes(uint8_t* data, uint16_t length);
+
+    /**
+     * Parses available bytes until the packet is completed.
+     * Returns false if the packet is malformed.
+     */
+    bool readIncoming();
+    bool parseByte(uint8_t byte);
+    void beginPacket();
+    void beginPayload();
+    void endPayload();
+    void processPacket();
+    void close();
+
+    Client& _client;
+    HAMqttClientListener* _listener;
+    State _state;
+    uint16_t _socketTimeout;
+    uint16_t _nextPacketId;
+    uint32_t _lastOutAt;
+    uint32_t _lastInAt;
+    bool _pingOutstanding;
+
+    ParserState _parserState;
+    uint8_t _header;
+    uint32_t _remainingLength;
+    uint8_t _lengthShift;
+    uint16_t _fieldLength;
+    uint16_t _fieldRead;
+    uint16_t _packetId;
+    bool _skipMessage;
+    uint32_t _skippedMessagesNb;
+    uint8_t _body[4];
+    char* _topic;
+    uint16_t _topicSize;
+};
+
+#endif
+#endif
@@ -0,0 +1,52 @@
+#ifndef AHA_HAMQTTSTATIC_H
+#define AHA_HAMQTTSTATIC_H
+
+#include "HAMqtt.h"
+
+/**
+ * Variant of the HAMqtt class that uses embedded storage instead of the heap.
+ * Adding more devices types or subscriptions than the given capacity fails.
+ *
+ * @tparam MaxDevicesTypes Maximum number of devices types (entities) registered in the instance.
+ * @tparam MaxSubscriptions Maximum number of topics subscribed by the devices types.
+ * @tparam ReceiveTopicSize Size of the received topic's buffer (including null terminator).
+ *         Used only by the built-in MQTT client, it needs to fit the longest subscribed topic.
+ */
+template <
+    uint16_t MaxDevicesTypes,
+    uint16_t MaxSubscriptions = MaxDevicesTypes,
+    uint16_t ReceiveTopicSize = ARDUINOHA_RECEIVE_TOPIC_SIZE
+>
+class HAMqttStatic : public HAMqtt
+{
+public:
+    HAMqttStatic(Client& netClient, HADevice& device) :
+        HAMqtt(
+            netClient,
+            device,
+            _devicesTypesStorage,
+            MaxDevicesTypes,
+            _subscriptionsStorage,
+            MaxSubscriptions,
+#if defined(ARDUINOHA_NATIVE_MQTT)
+            _receiveTopicStorage,
+            ReceiveTopicSize
+#else
+            nullptr,
+            0
+#endif
+        )
+    {
+
+    }
+
+private:
+    BaseDeviceType* _devicesTypesStorage[MaxDevicesTypes];
+    HASubscription _subscriptionsStorage[MaxSubscriptions];
+
+#if defined(ARDUINOHA_NATIVE_MQTT)
+    char _receiveTopicStorage[ReceiveTopicSize];
+#endif
+};
+
+#endif
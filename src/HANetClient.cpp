@@ -0,0 +1,182 @@
+#include <Arduino.h>
+
+#include "HANetClient.h"
+
+static const uint8_t ConnAckLength = 4;
+static const uint8_t ConnAckFlagsIndex = 2;
+
+HANetClient::HANetClient(Client& client) :
+    _client(client),
+    _bufferingDepth(0),
+    _connAckBytesNb(ConnAckLength),
+    _sessionPresent(false),
+    _lastWriteAt(0),
+    _lastReadAt(0),
+    _bytesWritten(0)
+#if ARDUINOHA_WRITE_BUFFER_SIZE > 0
+    , _bufferLength(0)
+#endif
+{
+
+}
+
+void HANetClient::beginBuffering()
+{
+    _bufferingDepth++;
+}
+
+bool HANetClient::endBuffering()
+{
+    if (_bufferingDepth > 0 && --_bufferingDepth > 0) {
+        return true; // the outermost buffering flushes the data
+    }
+
+    return flushBuffer();
+}
+
+void HANetClient::expectConnAck()
+{
+    _connAckBytesNb = 0;
+    _sessionPresent = false;
+}
+
+int HANetClient::connect(IPAddress ip, uint16_t port)
+{
+    _lastWriteAt = _lastReadAt = ARDUINOHA_MILLIS();
+    return _client.connect(ip, port);
+}
+
+int HANetClient::connect(const char* host, uint16_t port)
+{
+    _lastWriteAt = _lastReadAt = ARDUINOHA_MILLIS();
+    return _client.connect(host, port);
+}
+
+size_t HANetClient::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t HANetClient::write(const uint8_t* buf, size_t size)
+{
+    _lastWriteAt = ARDUINOHA_MILLIS();
+    _bytesWritten += size;
+
+#if ARDUINOHA_WRITE_BUFFER_SIZE > 0
+    if (_bufferingDepth == 0) {
+        return _client.write(buf, size);
+    }
+
+    size_t written = 0;
+    while (written < size) {
+        size_t chunkSize = ARDUINOHA_WRITE_BUFFER_SIZE - _bufferLength;
+        if (chunkSize > (size - written)) {
+            chunkSize = size - written;
+        }
+
+        memcpy(&_buffer[_bufferLength], &buf[written], chunkSize);
+        _bufferLength += chunkSize;
+        written += chunkSize;
+
+        if (_bufferLength == ARDUINOHA_WRITE_BUFFER_SIZE && !flushBuffer()) {
+            return 0;
+        }
+    }
+
+    return size;
+#else
+    return _client.write(buf, size);
+#endif
+}
+
+int HANetClient::available()
+{
+    return _client.available();
+}
+
+int HANetClient::read()
+{
+    const int& b = _client.read();
+    if (b >= 0) {
+        _lastReadAt = ARDUINOHA_MILLIS();
+    }
+
+    inspectIncomingByte(b);
+
+    return b;
+}
+
+int HANetClient::read(uint8_t* buf, size_t size)
+{
+    const int& result = _client.read(buf, size);
+    if (result > 0) {
+        _lastReadAt = ARDUINOHA_MILLIS();
+    }
+
+    for (int i = 0; i < result && _connAckBytesNb < ConnAckLength; i++) {
+        inspectIncomingByte(buf[i]);
+    }
+
+    return result;
+}
+
+int HANetClient::peek()
+{
+    return _client.peek();
+}
+
+void HANetClient::flush()
+{
+    flushBuffer();
+    _client.flush();
+}
+
+void HANetClient::stop()
+{
+    _bufferingDepth = 0;
+
+#if ARDUINOHA_WRITE_BUFFER_SIZE > 0
+    _bufferLength = 0; // data of the broken connection is useless
+#endif
+
+    _client.stop();
+}
+
+uint8_t HANetClient::connected()
+{
+    return _client.connected();
+}
+
+HANetClient::operator bool()
+{
+    return static_cast<bool>(_client);
+}
+
+void HANetClient::inspectIncomingByte(int b)
+{
+    if (b < 0 || _connAckBytesNb >= ConnAckLength) {
+        return;
+    }
+
+    if (_connAckBytesNb == ConnAckFlagsIndex) {
+        _sessionPresent = (b & 0x01);
+    }
+
+    _connAckBytesNb++;
+}
+
+bool HANetClient::flushBuffer()
+{
+#if ARDUINOHA_WRITE_BUFFER_SIZE > 0
+    if (_bufferLength == 0) {
+        return true;
+    }
+
+    const uint16_t length = _bufferLength;
+    _bufferLength = 0;
+
+    return (_client.write(_buffer, length) == length);
+#else
+    return true;
+#endif
+}
@@ -0,0 +1,91 @@
+#ifndef AHA_HANETCLIENT_H
+#define AHA_HANETCLIENT_H
+
+#include <Client.h>
+
+#include "ArduinoHADefines.h"
+
+/**
+ * Network client used by the MQTT layer. It forwards all calls to the client
+ * provided by the user and combines writes while buffering is enabled.
+ */
+class HANetClient : public Client
+{
+public:
+    HANetClient(Client& client);
+
+    /**
+     * Starts combining writes in the internal buffer.
+     * Calls may be nested, e.g. a single message within a batch of messages.
+     */
+    void beginBuffering();
+
+    /**
+     * Flushes the internal buffer and stops combining writes once
+     * the outermost buffering ends (nested calls return true).
+     * Returns false if the buffered data couldn't be written.
+     */
+    bool endBuffering();
+
+    /**
+     * Starts inspection of the incoming CONNACK packet.
+     * It needs to be called right before the CONNECT packet is sent.
+     */
+    void expectConnAck();
+
+    /**
+     * Returns "session present" flag of the last received CONNACK packet.
+     */
+    inline bool isSessionPresent() const
+        { return _sessionPresent; }
+
+    /**
+     * Returns time (millis) of the last write to the client.
+     */
+    inline uint32_t getLastWriteAt() const
+        { return _lastWriteAt; }
+
+    /**
+     * Returns time (millis) of the last read from the client.
+     */
+    inline uint32_t getLastReadAt() const
+        { return _lastReadAt; }
+
+    /**
+     * Returns number of bytes written to the client since the start.
+     */
+    inline uint32_t getBytesWritten() const
+        { return _bytesWritten; }
+
+    virtual int connect(IPAddress ip, uint16_t port) override;
+    virtual int connect(const char* host, uint16_t port) override;
+    virtual size_t write(uint8_t b) override;
+    virtual size_t write(const uint8_t* buf, size_t size) override;
+    virtual int available() override;
+    virtual int read() override;
+    virtual int read(uint8_t* buf, size_t size) override;
+    virtual int peek() override;
+    virtual void flush() override;
+    virtual void stop() override;
+    virtual uint8_t connected() override;
+    virtual operator bool() override;
+
+private:
+    bool flushBuffer();
+    void inspectIncomingByte(int b);
+
+    Client& _client;
+    uint8_t _bufferingDepth;
+    uint8_t _connAckBytesNb;
+    bool _sessionPresent;
+    uint32_t _lastWriteAt;
+    uint32_t _lastReadAt;
+    uint32_t _bytesWritten;
+
+#if ARDUINOHA_WRITE_BUFFER_SIZE > 0
+    uint16_t _bufferLength;
+    uint8_t _buffer[ARDUINOHA_WRITE_BUFFER_SIZE];
+#endif
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+
+#include "HAPublishQueue.h"
+
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+
+HAPublishQueue::HAPublishQueue() :
+    _head(0),
+    _size(0)
+{
+
+}
+
+bool HAPublishQueue::push(const char* topic, const char* payload, bool retained)
+{
+    const uint16_t& topicLength = strlen(topic);
+    const uint16_t& payloadLength = strlen(payload);
+
+    if (topicLength >= ARDUINOHA_QUEUE_TOPIC_SIZE ||
+            payloadLength >= ARDUINOHA_QUEUE_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    if (retained) {
+        for (uint8_t i = 0; i < _size; i++) {
+            Message* message = &_messages[(_head + i) % ARDUINOHA_PUBLISH_QUEUE_SIZE];
+            if (message->retained && strcmp(message->topic, topic) == 0) {
+                strcpy(message->payload, payload);
+                return true;
+            }
+        }
+    }
+
+    if (_size == ARDUINOHA_PUBLISH_QUEUE_SIZE) {
+        return false;
+    }
+
+    Message* message = &_messages[(_head + _size) % ARDUINOHA_PUBLISH_QUEUE_SIZE];
+    strcpy(message->topic, topic);
+    strcpy(message->payload, payload);
+    message->retained = retained;
+
+    _size++;
+    return true;
+}
+
+const HAPublishQueue::Message* HAPublishQueue::front() const
+{
+    if (_size == 0) {
+        return nullptr;
+    }
+
+    return &_messages[_head];
+}
+
+void HAPublishQueue::pop()
+{
+    if (_size == 0) {
+        return;
+    }
+
+    _head = (_head + 1) % ARDUINOHA_PUBLISH_QUEUE_SIZE;
+    _size--;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef AHA_HAPUBLISHQUEUE_H
+#define AHA_HAPUBLISHQUEUE_H
+
+#include <stdint.h>
+
+#include "ArduinoHADefines.h"
+
+#if ARDUINOHA_PUBLISH_QUEUE_SIZE > 0
+
+/**
+ * Fixed-capacity FIFO of messages waiting for the connection with the broker.
+ * Retained messages with the same topic are coalesced, so the queue holds
+ * only the latest state of each entity. Non-retained messages (events)
+ * are always appended in order.
+ */
+class HAPublishQueue
+{
+public:
+    struct Message {
+        char topic[ARDUINOHA_QUEUE_TOPIC_SIZE];
+        char payload[ARDUINOHA_QUEUE_PAYLOAD_SIZE];
+        bool retained;
+    };
+
+    HAPublishQueue();
+
+    /**
+     * Adds message to the end of the queue or replaces payload of the queued
+     * retained message with the same topic.
+     * Returns false if the queue is full or the message doesn't fit the slot.
+     *
+     * @param topic Topic of the message.
+     * @param payload Payload of the message.
+     * @param retained Determines whether message should be retained.
+     */
+    bool push(const char* topic, const char* payload, bool retained);
+
+    /**
+     * Returns the oldest message in the queue or nullptr if the queue is empty.
+     */
+    const Message* front() const;
+
+    /**
+     * Removes the oldest message from the queue.
+     */
+    void pop();
+
+    inline bool isEmpty() const
+        { return (_size == 0); }
+
+    inline uint8_t size() const
+        { return _size; }
+
+private:
+    Message _messages[ARDUINOHA_PUBLISH_QUEUE_SIZE];
+    uint8_t _head;
+    uint8_t _size;
+};
+
+#endif
+#endif
@@ -0,0 +1,156 @@
+#include <Arduino.h>
+
+#include "HAScheduler.h"
+
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+
+HAScheduler::HAScheduler() :
+    _size(0)
+{
+
+}
+
+bool HAScheduler::schedule(
+    HASCHEDULER_CALLBACK,
+    uint32_t delay,
+    uint32_t interval,
+    void* context
+)
+{
+    if (callback == nullptr || _size == ARDUINOHA_SCHEDULER_SIZE) {
+        return false;
+    }
+
+    Task& task = _tasks[_size];
+    task.dueAt = ARDUINOHA_MILLIS() + delay;
+    task.interval = interval;
+    task.callback = callback;
+    task.context = context;
+
+    siftUp(_size++);
+    return true;
+}
+
+bool HAScheduler::cancel(HASCHEDULER_CALLBACK, void* context)
+{
+    for (uint8_t i = 0; i < _size; i++) {
+        if (_tasks[i].callback == callback && _tasks[i].context == context) {
+            remove(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint8_t HAScheduler::run(uint32_t budget)
+{
+    const uint32_t& startedAt = ARDUINOHA_MICROS();
+    uint8_t executedNb = 0;
+
+    while (_size > 0) {
+        const uint32_t& now = ARDUINOHA_MILLIS();
+        if ((int32_t)(now - _tasks[0].dueAt) < 0) {
+            break; // the earliest task isn't due yet
+        }
+
+        if (executedNb > 0 && (ARDUINOHA_MICROS() - startedAt) >= budget) {
+            break;
+        }
+
+        // the task is rescheduled before the call, so the callback may cancel it
+        const Task task = _tasks[0];
+        if (task.interval > 0) {
+            _tasks[0].dueAt += task.interval;
+
+            // a task that fell behind doesn't run in a burst to catch up
+            if ((int32_t)(now - _tasks[0].dueAt) >= 0) {
+                _tasks[0].dueAt = now + task.interval;
+            }
+
+            siftDown(0);
+        } else {
+            remove(0);
+        }
+
+        task.callback(task.context);
+        executedNb++;
+    }
+
+    return executedNb;
+}
+
+uint32_t HAScheduler::nextDueIn() const
+{
+    if (_size == 0) {
+        return UINT32_MAX;
+    }
+
+    const int32_t& remaining = (int32_t)(_tasks[0].dueAt - ARDUINOHA_MILLIS());
+    return (remaining > 0 ? remaining : 0);
+}
+
+bool HAScheduler::isBefore(const Task& a, const Task& b) const
+{
+    // the difference is signed, so overflow of millis() doesn't break the order
+    return ((int32_t)(a.dueAt - b.dueAt) < 0);
+}
+
+void HAScheduler::swap(uint8_t a, uint8_t b)
+{
+    const Task tmp = _tasks[a];
+    _tasks[a] = _tasks[b];
+    _tasks[b] = tmp;
+}
+
+void HAScheduler::siftUp(uint8_t index)
+{
+    while (index > 0) {
+        const uint8_t& parent = (index - 1) / 2;
+        if (!isBefore(_tasks[index], _tasks[parent])) {
+            break;
+        }
+
+        swap(index, parent);
+        index = parent;
+    }
+}
+
+void HAScheduler::siftDown(uint8_t index)
+{
+    while (true) {
+        const uint8_t& left = index * 2 + 1;
+        const uint8_t& right = left + 1;
+        uint8_t smallest = index;
+
+        if (left < _size && isBefore(_tasks[left], _tasks[smallest])) {
+            smallest = left;
+        }
+
+        if (right < _size && isBefore(_tasks[right], _tasks[smallest])) {
+            smallest = right;
+        }
+
+        if (smallest == index) {
+            break;
+        }
+
+        swap(index, smallest);
+        index = smallest;
+    }
+}
+
+void HAScheduler::remove(uint8_t index)
+{
+    _size--;
+
+    if (index == _size) {
+        return;
+    }
+
+    _tasks[index] = _tasks[_size];
+    siftDown(index);
+    siftUp(index);
+}
+
+#endif
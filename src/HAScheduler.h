@@ -0,0 +1,85 @@
+#ifndef AHA_HASCHEDULER_H
+#define AHA_HASCHEDULER_H
+
+#include <stdint.h>
+
+#include "ArduinoHADefines.h"
+
+#define HASCHEDULER_CALLBACK void (*callback)(void* context)
+
+#if ARDUINOHA_SCHEDULER_SIZE > 0
+
+/**
+ * Fixed-capacity scheduler of cooperative tasks.
+ * Tasks are kept in a min-heap ordered by their deadlines, so the next
+ * task to run is always on top of the heap.
+ */
+class HAScheduler
+{
+public:
+    struct Task {
+        uint32_t dueAt;
+        uint32_t interval; // 0 means that the task runs once
+        void (*callback)(void* context);
+        void* context;
+    };
+
+    HAScheduler();
+
+    /**
+     * Schedules the callback to be called after the given delay.
+     * Returns false if there is no free slot for the task.
+     *
+     * @param callback Function that will be called.
+     * @param delay Delay of the first call in milliseconds.
+     * @param interval Interval between calls in milliseconds (0 makes one-shot task).
+     * @param context Pointer that will be passed to the callback.
+     */
+    bool schedule(
+        HASCHEDULER_CALLBACK,
+        uint32_t delay,
+        uint32_t interval = 0,
+        void* context = nullptr
+    );
+
+    /**
+     * Removes task with the given callback and context.
+     * Returns false if the task wasn't found.
+     *
+     * @param callback
+     * @param context
+     */
+    bool cancel(HASCHEDULER_CALLBACK, void* context = nullptr);
+
+    /**
+     * Runs tasks whose deadlines have passed in order of their deadlines.
+     * At least one due task is executed, the following ones are executed
+     * as long as the time budget allows.
+     * Returns number of executed tasks.
+     *
+     * @param budget Time budget in microseconds.
+     */
+    uint8_t run(uint32_t budget);
+
+    /**
+     * Returns number of milliseconds until the deadline of the next task
+     * (0 if it's overdue) or UINT32_MAX if there are no tasks.
+     */
+    uint32_t nextDueIn() const;
+
+    inline uint8_t size() const
+        { return _size; }
+
+private:
+    bool isBefore(const Task& a, const Task& b) const;
+    void swap(uint8_t a, uint8_t b);
+    void siftUp(uint8_t index);
+    void siftDown(uint8_t index);
+    void remove(uint8_t index);
+
+    Task _tasks[ARDUINOHA_SCHEDULER_SIZE];
+    uint8_t _size;
+};
+
+#endif
+#endif
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 
 #include "HAUtils.h"
+#include "ArduinoHADefines.h"
 
 bool HAUtils::endsWith(const char* str, const char* suffix)
 {
@@ -40,12 +41,49 @@ char* HAUtils::byteArrayToStr(
     const uint16_t& length
 )
 {
-    char* dst = (char*)malloc((length * 2) + 1); // include null terminator
+    char* dst = (char*)ARDUINOHA_MALLOC((length * 2) + 1); // include null terminator
     byteArrayToStr(dst, src, length);
 
     return dst;
 }
 
+uint32_t HAUtils::hash(const char* str, uint16_t* length)
+{
+    uint32_t hash = HashOffsetBasis;
+    const char* ptr = str;
+
+    while (*ptr != '\0') {
+        hash ^= (uint8_t)(*ptr++);
+        hash *= 16777619UL; // FNV prime
+    }
+
+    if (length != nullptr) {
+        *length = (ptr - str);
+    }
+
+    return hash;
+}
+
+uint32_t HAUtils::timeLeft(uint32_t since, uint32_t interval)
+{
+    const uint32_t& elapsed = ARDUINOHA_MILLIS() - since;
+    return (elapsed >= interval ? 0 : interval - elapsed);
+}
+
+uint32_t HAUtils::updateHash(
+    uint32_t hash,
+    const uint8_t* data,
+    uint16_t length
+)
+{
+    for (uint16_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619UL; // FNV prime
+    }
+
+    return hash;
+}
+
 uint8_t HAUtils::getValueTypeLength(const ValueType& type)
 {
     switch(type) {
@@ -32,6 +32,42 @@ public:
         const uint16_t& length
     );
 
+    /**
+     * Calculates 32-bit FNV-1a hash of the given string.
+     *
+     * @param str String to hash.
+     * @param length If not null, length of the string is saved to the given variable.
+     */
+    static uint32_t hash(
+        const char* str,
+        uint16_t* length = nullptr
+    );
+
+    /**
+     * Continues calculation of the 32-bit FNV-1a hash with the given bytes.
+     * The first call should be made with `HashOffsetBasis` as the hash.
+     *
+     * @param hash Hash calculated so far.
+     * @param data Bytes to hash.
+     * @param length Number of bytes.
+     */
+    static uint32_t updateHash(
+        uint32_t hash,
+        const uint8_t* data,
+        uint16_t length
+    );
+
+    static const uint32_t HashOffsetBasis = 2166136261UL;
+
+    /**
+     * Returns number of milliseconds left until the interval that started
+     * at the given time passes (0 if it has already passed).
+     *
+     * @param since Start of the interval (millis).
+     * @param interval Length of the interval in milliseconds.
+     */
+    static uint32_t timeLeft(uint32_t since, uint32_t interval);
+
     template <typename A, typename B >
     static bool compareType(A a, B b) { return false; }
 
@@ -10,7 +10,9 @@ BaseDeviceType::BaseDeviceType(
     _mqtt(mqtt),
     _componentName(componentName),
     _name(name),
-    _availability(AvailabilityDefault)
+    _availability(AvailabilityDefault),
+    _configHash(0),
+    _index(UINT16_MAX)
 {
     _mqtt.addDeviceType(this);
 }
@@ -26,6 +28,46 @@ void BaseDeviceType::setAvailability(bool online)
     publishAvailability();
 }
 
+uint16_t BaseDeviceType::calculateAvailabilityFieldSize() const
+{
+    if (isAvailabilityConfigured()) {
+        return DeviceTypeSerializer::calculateAvailabilityFieldSize(
+            mqtt(),
+            _componentName,
+            _name
+        );
+    }
+
+    const HADevice* device = _mqtt.getDevice();
+    if (device != nullptr && device->isSharedAvailabilityEnabled()) {
+        return DeviceTypeSerializer::calculateDeviceAvailabilityFieldSize(mqtt());
+    }
+
+    return 0;
+}
+
+void BaseDeviceType::mqttWriteAvailabilityField() const
+{
+    if (isAvailabilityConfigured()) {
+        DeviceTypeSerializer::mqttWriteAvailabilityField(
+            mqtt(),
+            _componentName,
+            _name
+        );
+        return;
+    }
+
+    const HADevice* device = _mqtt.getDevice();
+    if (device != nullptr && device->isSharedAvailabilityEnabled()) {
+        DeviceTypeSerializer::mqttWriteDeviceAvailabilityField(mqtt());
+    }
+}
+
+bool BaseDeviceType::deferPublishing()
+{
+    return _mqtt.markDirty(this);
+}
+
 void BaseDeviceType::publishAvailability()
 {
     if (_availability == AvailabilityDefault ||
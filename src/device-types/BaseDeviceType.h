@@ -22,6 +22,18 @@ public:
 
     virtual void setAvailability(bool online);
 
+    /**
+     * Returns fingerprint of the config that was published most recently (0 if none).
+     * The config is published again only if its fingerprint changes.
+     * The value may be saved in persistent storage and restored using
+     * `setConfigHash` after reboot, so unchanged config isn't published again.
+     */
+    inline uint32_t getConfigHash() const
+        { return _configHash; }
+
+    inline void setConfigHash(uint32_t hash)
+        { _configHash = hash; }
+
 protected:
     inline HAMqtt* mqtt() const
         { return &_mqtt; }
@@ -35,15 +47,83 @@ protected:
     inline bool isAvailabilityConfigured() const
         { return (_availability != AvailabilityDefault); }
 
+    /**
+     * Returns size of the "avty_t" config field.
+     * The device type's own availability topic takes precedence over
+     * the device's shared availability topic (see HADevice::enableSharedAvailability).
+     */
+    uint16_t calculateAvailabilityFieldSize() const;
+
+    /**
+     * Writes the "avty_t" config field (if any availability is configured).
+     */
+    void mqttWriteAvailabilityField() const;
+
+    /**
+     * Called each time the connection with the MQTT broker is acquired,
+     * before any of the devices types is announced.
+     * Topics that the device type listens to should be subscribed here.
+     */
+    virtual void onMqttSubscribe() { };
+
     virtual void onMqttConnected() = 0;
+
+    /**
+     * Called in each cycle of HAMqtt::loop.
+     * Device types may use it to publish deferred states.
+     */
+    virtual void onMqttLoop() { };
+
+    /**
+     * Returns number of milliseconds until the device type needs
+     * the next onMqttLoop call (UINT32_MAX if it doesn't need it at all).
+     */
+    virtual uint32_t nextLoopIn() const { return UINT32_MAX; };
     virtual void onMqttMessage(
         const char* topic,
         const uint8_t* payload,
         const uint16_t& length
     ) { };
 
+    /**
+     * Streaming counterpart of onMqttMessage. The payload of the message
+     * is passed in chunks as it's received, so it may be processed in
+     * constant RAM regardless of its length. Messages that fit the receive
+     * buffer are passed to onMqttMessage afterwards as well.
+     * With PubSubClient the whole payload is passed as a single chunk.
+     *
+     * @param topic Topic of the message.
+     * @param length Total length of the payload.
+     */
+    virtual void onMqttMessageBegin(
+        const char* topic,
+        const uint32_t& length
+    ) { };
+
+    virtual void onMqttMessageData(
+        const uint8_t* data,
+        const uint16_t& length
+    ) { };
+
+    virtual void onMqttMessageEnd() { };
+
     virtual void publishAvailability();
 
+    /**
+     * Marks the device type as dirty if deferred publishing is enabled
+     * (see HAMqtt::setDeferredPublishing). Returns false if the state
+     * needs to be published right away.
+     */
+    bool deferPublishing();
+
+    /**
+     * Called by HAMqtt::flush if the device type was marked as dirty.
+     * The latest state of the device type should be published here.
+     * Returns false if the state couldn't be published, so the device type
+     * stays dirty and the state is published by the next flush.
+     */
+    virtual bool onMqttFlush() { return true; };
+
     const char* const _componentName;
     const char* const _name;
 
@@ -56,6 +136,8 @@ private:
 
     HAMqtt& _mqtt;
     Availability _availability;
+    uint32_t _configHash;
+    uint16_t _index; // position in the HAMqtt's registry
 
     friend class HAMqtt;
 };
@@ -78,6 +78,42 @@ uint16_t DeviceTypeSerializer::generateTopic(
     return strlen(output) + 1; // size with null terminator
 }
 
+uint16_t DeviceTypeSerializer::calculateDeviceAvailabilityTopicLength(
+    const HAMqtt* mqtt,
+    bool includeNullTerminator
+)
+{
+    const char* prefix = mqtt->getDiscoveryPrefix();
+    const HADevice* device = mqtt->getDevice();
+    if (prefix == nullptr || device == nullptr) {
+        return 0;
+    }
+
+    uint16_t size =
+        strlen(prefix) + 1 + // with slash
+        strlen(device->getUniqueId()) + 1 + // with slash
+        strlen(AvailabilityTopic);
+
+    if (includeNullTerminator) {
+        size += 1;
+    }
+
+    return size;
+}
+
+uint16_t DeviceTypeSerializer::generateDeviceAvailabilityTopic(
+    const HAMqtt* mqtt,
+    char* output
+)
+{
+    strcpy(output, mqtt->getDiscoveryPrefix());
+    strcat_P(output, CharSlash);
+    strcat(output, mqtt->getDevice()->getUniqueId());
+    strcat_P(output, CharSlash);
+    strcat(output, AvailabilityTopic);
+    return strlen(output) + 1; // size with null terminator
+}
+
 uint16_t DeviceTypeSerializer::calculateBaseJsonDataSize()
 {
     return 2; // opening and closing brackets of the JSON data
@@ -136,6 +172,27 @@ uint16_t DeviceTypeSerializer::calculateAvailabilityFieldSize(
     return availabilityTopicLength + 12; // 12 - length of the JSON decorators for this field
 }
 
+uint16_t DeviceTypeSerializer::calculateDeviceAvailabilityFieldSize(
+    const HAMqtt* mqtt
+)
+{
+    if (mqtt == nullptr) {
+        return 0;
+    }
+
+    const uint16_t& availabilityTopicLength = calculateDeviceAvailabilityTopicLength(
+        mqtt,
+        false
+    );
+
+    if (availabilityTopicLength == 0) {
+        return 0;
+    }
+
+    // Field format: ,"avty_t":"[TOPIC]"
+    return availabilityTopicLength + 12; // 12 - length of the JSON decorators for this field
+}
+
 uint16_t DeviceTypeSerializer::calculateDeviceFieldSize(
     const char* serializedDevice
 )
@@ -250,6 +307,24 @@ void DeviceTypeSerializer::mqttWriteAvailabilityField(
     mqttWriteConstCharField(mqtt, Prefix, availabilityTopic);
 }
 
+void DeviceTypeSerializer::mqttWriteDeviceAvailabilityField(HAMqtt* mqtt)
+{
+    if (mqtt == nullptr) {
+        return;
+    }
+
+    const uint16_t& topicSize = calculateDeviceAvailabilityTopicLength(mqtt);
+    if (topicSize == 0) {
+        return;
+    }
+
+    char availabilityTopic[topicSize];
+    generateDeviceAvailabilityTopic(mqtt, availabilityTopic);
+
+    static const char Prefix[] PROGMEM = {",\"avty_t\":\""};
+    mqttWriteConstCharField(mqtt, Prefix, availabilityTopic);
+}
+
 void DeviceTypeSerializer::mqttWriteDeviceField(
     HAMqtt* mqtt,
     const char* serializedDevice
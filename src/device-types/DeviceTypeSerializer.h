@@ -55,6 +55,29 @@ public:
         const char* suffix
     );
 
+    /**
+     * Calculates length of the device's shared availability topic.
+     * Topic format: [discovery prefix]/[device ID]/avail
+     *
+     * @param includeNullTerminator
+     */
+    static uint16_t calculateDeviceAvailabilityTopicLength(
+        const HAMqtt* mqtt,
+        bool includeNullTerminator = true
+    );
+
+    /**
+     * Generates the device's shared availability topic and saves it to the given buffer.
+     * Please note that size of the buffer must be calculated by
+     * `calculateDeviceAvailabilityTopicLength` method first.
+     *
+     * @param output
+     */
+    static uint16_t generateDeviceAvailabilityTopic(
+        const HAMqtt* mqtt,
+        char* output
+    );
+
     static uint16_t calculateBaseJsonDataSize();
     static uint16_t calculateNameFieldSize(
         const char* name
@@ -68,6 +91,9 @@ public:
         const char* componentName,
         const char* name
     );
+    static uint16_t calculateDeviceAvailabilityFieldSize(
+        const HAMqtt* mqtt
+    );
     static uint16_t calculateDeviceFieldSize(
         const char* serializedDevice
     );
@@ -89,6 +115,7 @@ public:
         const char* componentName,
         const char* name
     );
+    static void mqttWriteDeviceAvailabilityField(HAMqtt* mqtt);
     static void mqttWriteDeviceField(
         HAMqtt* mqtt,
         const char* serializedDevice
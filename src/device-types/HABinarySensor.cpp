@@ -50,7 +50,7 @@ bool HABinarySensor::setState(bool state)
         return false;
     }
 
-    if (publishState(state)) {
+    if (deferPublishing() || publishState(state)) {
         _currentState = state;
         return true;
     }
@@ -58,6 +58,11 @@ bool HABinarySensor::setState(bool state)
     return false;
 }
 
+bool HABinarySensor::onMqttFlush()
+{
+    return publishState(_currentState);
+}
+
 void HABinarySensor::publishConfig()
 {
     const HADevice* device = mqtt()->getDevice();
@@ -100,9 +105,20 @@ void HABinarySensor::publishConfig()
         return;
     }
 
+    mqtt()->beginFingerprint(topic);
+    writeSerializedData(serializedDevice);
+    const uint32_t& configHash = mqtt()->endFingerprint();
+
+    if (configHash == getConfigHash()) {
+        return; // the same config was published already
+    }
+
     if (mqtt()->beginPublish(topic, dataLength, true)) {
         writeSerializedData(serializedDevice);
-        mqtt()->endPublish();
+
+        if (mqtt()->endPublish()) {
+            setConfigHash(configHash);
+        }
     }
 }
 
@@ -165,13 +181,7 @@ uint16_t HABinarySensor::calculateSerializedLength(
     size += DeviceTypeSerializer::calculateUniqueIdFieldSize(device, name());
     size += DeviceTypeSerializer::calculateDeviceFieldSize(serializedDevice);
 
-    if (isAvailabilityConfigured()) {
-        size += DeviceTypeSerializer::calculateAvailabilityFieldSize(
-            mqtt(),
-            componentName(),
-            name()
-        );
-    }
+    size += calculateAvailabilityFieldSize();
 
     // state topic
     {
@@ -246,13 +256,7 @@ bool HABinarySensor::writeSerializedData(const char* serializedDevice) const
     DeviceTypeSerializer::mqttWriteNameField(mqtt(), name());
     DeviceTypeSerializer::mqttWriteUniqueIdField(mqtt(), name());
 
-    if (isAvailabilityConfigured()) {
-        DeviceTypeSerializer::mqttWriteAvailabilityField(
-            mqtt(),
-            componentName(),
-            name()
-        );
-    }
+    mqttWriteAvailabilityField();
 
     DeviceTypeSerializer::mqttWriteDeviceField(mqtt(), serializedDevice);
     DeviceTypeSerializer::mqttWriteEndJson(mqtt());
@@ -40,13 +40,19 @@ public:
      */
     virtual void onMqttConnected() override;
 
+    /**
+     * Publishes the latest state of the sensor (see HAMqtt::setDeferredPublishing).
+     */
+    virtual bool onMqttFlush() override;
+
     /**
      * Changes state of the sensor and publishes MQTT message.
      * Please note that if a new value is the same as previous one,
      * the MQTT message won't be published.
+     * With deferred publishing the message is published by HAMqtt::flush.
      *
      * @param state New state of the sensor.
-     * @returns Returns true if MQTT message has been published successfully.
+     * @returns Returns true if MQTT message has been published or queued successfully.
      */
     bool setState(bool state);
 
@@ -18,7 +18,15 @@ HASensor<T>::HASensor(
     _class(nullptr),
     _units(nullptr),
     _valueType(HAUtils::determineValueType<T>()),
-    _currentValue(initialValue)
+    _currentValue(initialValue),
+    _publishedValue(initialValue),
+    _pendingValue(false),
+    _lastPublishedAt(0),
+    _minPublishInterval(0),
+    _maxPublishInterval(0),
+    _absoluteDeadband(0),
+    _relativeDeadband(0),
+    _suppressedUpdatesNb(0)
 {
 
 }
@@ -34,7 +42,15 @@ HASensor<T>::HASensor(
     _class(deviceClass),
     _units(nullptr),
     _valueType(HAUtils::determineValueType<T>()),
-    _currentValue(initialValue)
+    _currentValue(initialValue),
+    _publishedValue(initialValue),
+    _pendingValue(false),
+    _lastPublishedAt(0),
+    _minPublishInterval(0),
+    _maxPublishInterval(0),
+    _absoluteDeadband(0),
+    _relativeDeadband(0),
+    _suppressedUpdatesNb(0)
 {
 
 }
@@ -48,10 +64,59 @@ void HASensor<T>::onMqttConnected()
     }
 
     publishConfig();
-    publishValue(_currentValue);
+    publishCurrentValue();
     publishAvailability();
 }
 
+template <typename T>
+void HASensor<T>::onMqttLoop()
+{
+    if (!_pendingValue && _maxPublishInterval == 0) {
+        return;
+    }
+
+    // the current value is published by onMqttConnected once the broker is back
+    if (!mqtt()->isConnected()) {
+        return;
+    }
+
+    const uint32_t& elapsed = ARDUINOHA_MILLIS() - _lastPublishedAt;
+    if ((_pendingValue && elapsed >= _minPublishInterval) ||
+            (_maxPublishInterval > 0 && elapsed >= _maxPublishInterval)) {
+        publishCurrentValue();
+    }
+}
+
+template <typename T>
+uint32_t HASensor<T>::nextLoopIn() const
+{
+    uint32_t wakeupIn = UINT32_MAX;
+
+    // neither pending value nor heartbeat is published while the broker is disconnected
+    if (!mqtt()->isConnected()) {
+        return wakeupIn;
+    }
+
+    if (_pendingValue) {
+        wakeupIn = HAUtils::timeLeft(_lastPublishedAt, _minPublishInterval);
+    }
+
+    if (_maxPublishInterval > 0) {
+        const uint32_t& heartbeatIn = HAUtils::timeLeft(_lastPublishedAt, _maxPublishInterval);
+        if (heartbeatIn < wakeupIn) {
+            wakeupIn = heartbeatIn;
+        }
+    }
+
+    return wakeupIn;
+}
+
+template <typename T>
+bool HASensor<T>::onMqttFlush()
+{
+    return publishCurrentValue();
+}
+
 template <typename T>
 bool HASensor<T>::setValue(T value)
 {
@@ -64,8 +129,34 @@ bool HASensor<T>::setValue(T value)
         return true;
     }
 
+    if (isWithinDeadband(value)) {
+        _currentValue = value;
+        _pendingValue = false;
+        _suppressedUpdatesNb++;
+        return true;
+    }
+
+    if (_minPublishInterval > 0 &&
+            (ARDUINOHA_MILLIS() - _lastPublishedAt) < _minPublishInterval) {
+        if (_pendingValue) {
+            _suppressedUpdatesNb++; // previous value is replaced
+        }
+
+        _currentValue = value;
+        _pendingValue = true;
+        return true;
+    }
+
+    if (deferPublishing()) {
+        _currentValue = value;
+        return true;
+    }
+
     if (publishValue(value)) {
         _currentValue = value;
+        _publishedValue = value;
+        _pendingValue = false;
+        _lastPublishedAt = ARDUINOHA_MILLIS();
         return true;
     }
 
@@ -119,12 +210,66 @@ void HASensor<T>::publishConfig()
         return;
     }
 
+    mqtt()->beginFingerprint(topic);
+    writeSerializedData(serializedDevice);
+    const uint32_t& configHash = mqtt()->endFingerprint();
+
+    if (configHash == getConfigHash()) {
+        return; // the same config was published already
+    }
+
     if (mqtt()->beginPublish(topic, dataLength, true)) {
         writeSerializedData(serializedDevice);
-        mqtt()->endPublish();
+
+        if (mqtt()->endPublish()) {
+            setConfigHash(configHash);
+        }
     }
 }
 
+template <typename T>
+bool HASensor<T>::publishCurrentValue()
+{
+    if (!publishValue(_currentValue)) {
+        return false;
+    }
+
+    _publishedValue = _currentValue;
+    _pendingValue = false;
+    _lastPublishedAt = ARDUINOHA_MILLIS();
+    return true;
+}
+
+template <typename T>
+bool HASensor<T>::isWithinDeadband(T value) const
+{
+    if (_absoluteDeadband == 0 && _relativeDeadband == 0) {
+        return false;
+    }
+
+    double difference = (double)value - (double)_publishedValue;
+    if (difference < 0) {
+        difference = -difference;
+    }
+
+    if (_absoluteDeadband != 0 && difference < (double)_absoluteDeadband) {
+        return true;
+    }
+
+    if (_relativeDeadband != 0) {
+        double base = _publishedValue;
+        if (base < 0) {
+            base = -base;
+        }
+
+        if (difference < (_relativeDeadband * base)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 template <typename T>
 bool HASensor<T>::publishValue(T value)
 {
@@ -190,13 +335,7 @@ uint16_t HASensor<T>::calculateSerializedLength(
     size += DeviceTypeSerializer::calculateUniqueIdFieldSize(device, name());
     size += DeviceTypeSerializer::calculateDeviceFieldSize(serializedDevice);
 
-    if (isAvailabilityConfigured()) {
-        size += DeviceTypeSerializer::calculateAvailabilityFieldSize(
-            mqtt(),
-            componentName(),
-            name()
-        );
-    }
+    size += calculateAvailabilityFieldSize();
 
     {
         const uint16_t& topicSize = DeviceTypeSerializer::calculateTopicLength(
@@ -284,13 +423,7 @@ bool HASensor<T>::writeSerializedData(const char* serializedDevice) const
     DeviceTypeSerializer::mqttWriteNameField(mqtt(), name());
     DeviceTypeSerializer::mqttWriteUniqueIdField(mqtt(), name());
 
-    if (isAvailabilityConfigured()) {
-        DeviceTypeSerializer::mqttWriteAvailabilityField(
-            mqtt(),
-            componentName(),
-            name()
-        );
-    }
+    mqttWriteAvailabilityField();
 
     DeviceTypeSerializer::mqttWriteDeviceField(mqtt(), serializedDevice);
     DeviceTypeSerializer::mqttWriteEndJson(mqtt());
@@ -349,13 +482,18 @@ bool HASensor<T>::valueToStr(char* dst, T value) const
     }
 
     switch (_valueType) {
+        // itoa takes int that is 16-bit wide on AVR, so 32-bit values
+        // are formatted using long versions
         case HAUtils::ValueTypeUint8:
         case HAUtils::ValueTypeUint16:
         case HAUtils::ValueTypeUint32:
+            ultoa(static_cast<uint32_t>(value), dst, 10);
+            break;
+
         case HAUtils::ValueTypeInt8:
         case HAUtils::ValueTypeInt16:
         case HAUtils::ValueTypeInt32:
-            itoa(value, dst, 10);
+            ltoa(static_cast<int32_t>(value), dst, 10);
             break;
 
         case HAUtils::ValueTypeDouble:
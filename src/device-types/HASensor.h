@@ -42,13 +42,32 @@ public:
      */
     virtual void onMqttConnected() override;
 
+    /**
+     * Publishes deferred value and heartbeat of the sensor.
+     */
+    virtual void onMqttLoop() override;
+
+    /**
+     * Returns time left until the deferred value or heartbeat needs to be published.
+     */
+    virtual uint32_t nextLoopIn() const override;
+
+    /**
+     * Publishes the latest value of the sensor (see HAMqtt::setDeferredPublishing).
+     */
+    virtual bool onMqttFlush() override;
+
     /**
      * Changes state of the sensor and publishes MQTT message.
      * Please note that if a new value is the same as previous one,
      * the MQTT message won't be published.
+     * If the value changes within the minimum publish interval, it's published
+     * from the HAMqtt::loop once the interval elapses (only the latest value is published).
+     * Changes within the deadband are not published at all.
+     * With deferred publishing the message is published by HAMqtt::flush.
      *
      * @param state New state of the sensor.
-     * @returns Returns true if MQTT message has been published successfully.
+     * @returns Returns true if MQTT message has been published or queued successfully.
      */
     bool setValue(T value);
 
@@ -67,9 +86,45 @@ public:
     inline void setUnitOfMeasurement(const char* units)
         { _units = units; }
 
+    /**
+     * Sets minimum time between two consecutive publications of the value.
+     *
+     * @param interval Interval in milliseconds (0 disables the limit).
+     */
+    inline void setMinPublishInterval(uint32_t interval)
+        { _minPublishInterval = interval; }
+
+    /**
+     * Sets maximum time between two consecutive publications of the value.
+     * If the value doesn't change within this time, it's published again (heartbeat).
+     *
+     * @param interval Interval in milliseconds (0 disables the heartbeat).
+     */
+    inline void setMaxPublishInterval(uint32_t interval)
+        { _maxPublishInterval = interval; }
+
+    /**
+     * Sets deadband of the sensor. A new value is published only if its difference
+     * from the last published value is not smaller than both thresholds.
+     *
+     * @param absolute Absolute threshold (0 disables it).
+     * @param relative Threshold relative to the last published value, e.g. 0.05 for 5% (0 disables it).
+     */
+    inline void setDeadband(T absolute, float relative = 0)
+        { _absoluteDeadband = absolute; _relativeDeadband = relative; }
+
+    /**
+     * Returns number of values that weren't published due to the deadband
+     * or were replaced by a newer value within the minimum publish interval.
+     */
+    inline uint32_t getSuppressedUpdatesNb() const
+        { return _suppressedUpdatesNb; }
+
 private:
     void publishConfig();
+    bool publishCurrentValue();
     bool publishValue(T value);
+    bool isWithinDeadband(T value) const;
     uint16_t calculateSerializedLength(const char* serializedDevice) const;
     bool writeSerializedData(const char* serializedDevice) const;
     uint16_t calculateValueLength() const;
@@ -79,6 +134,14 @@ private:
     const char* _units;
     HAUtils::ValueType _valueType;
     T _currentValue;
+    T _publishedValue;
+    bool _pendingValue;
+    uint32_t _lastPublishedAt;
+    uint32_t _minPublishInterval;
+    uint32_t _maxPublishInterval;
+    T _absoluteDeadband;
+    float _relativeDeadband;
+    uint32_t _suppressedUpdatesNb;
 };
 
 #endif
@@ -2,7 +2,6 @@
 #include "../ArduinoHADefines.h"
 #include "../HAMqtt.h"
 #include "../HADevice.h"
-#include "../HAUtils.h"
 
 HASwitch::HASwitch(const char* name, bool initialState, HAMqtt& mqtt) :
     BaseDeviceType(mqtt, "switch", name),
@@ -12,6 +11,15 @@ HASwitch::HASwitch(const char* name, bool initialState, HAMqtt& mqtt) :
 
 }
 
+void HASwitch::onMqttSubscribe()
+{
+    if (strlen(name()) == 0) {
+        return;
+    }
+
+    subscribeCommandTopic();
+}
+
 void HASwitch::onMqttConnected()
 {
     if (strlen(name()) == 0) {
@@ -20,7 +28,6 @@ void HASwitch::onMqttConnected()
 
     publishConfig();
     publishState(_currentState);
-    subscribeCommandTopic();
     publishAvailability();
 }
 
@@ -34,17 +41,26 @@ void HASwitch::onMqttMessage(
         return;
     }
 
-    static const char Slash[] PROGMEM = {"/"};
-    // name + cmd topic + two slashes + null terminator
-    uint8_t suffixLength = strlen(name()) + strlen(DeviceTypeSerializer::CommandTopic) + 3;
-    char suffix[suffixLength];
+    const uint16_t& topicSize = DeviceTypeSerializer::calculateTopicLength(
+        mqtt(),
+        componentName(),
+        name(),
+        DeviceTypeSerializer::CommandTopic
+    );
+    if (topicSize == 0) {
+        return;
+    }
 
-    strcpy_P(suffix, Slash);
-    strcat(suffix, name());
-    strcat_P(suffix, Slash);
-    strcat(suffix, DeviceTypeSerializer::CommandTopic);
+    char commandTopic[topicSize];
+    DeviceTypeSerializer::generateTopic(
+        mqtt(),
+        commandTopic,
+        componentName(),
+        name(),
+        DeviceTypeSerializer::CommandTopic
+    );
 
-    if (HAUtils::endsWith(topic, suffix)) {
+    if (strcmp(topic, commandTopic) == 0) {
         bool onState = (length == strlen(DeviceTypeSerializer::StateOn));
         setState(onState);
     }
@@ -60,7 +76,7 @@ bool HASwitch::setState(bool state)
         return false;
     }
 
-    if (publishState(state)) {
+    if (deferPublishing() || publishState(state)) {
         _currentState = state;
         triggerCallback(_currentState);
         return true;
@@ -69,6 +85,11 @@ bool HASwitch::setState(bool state)
     return false;
 }
 
+bool HASwitch::onMqttFlush()
+{
+    return publishState(_currentState);
+}
+
 void HASwitch::triggerCallback(bool state)
 {
     if (_stateCallback == nullptr) {
@@ -120,9 +141,20 @@ void HASwitch::publishConfig()
         return;
     }
 
+    mqtt()->beginFingerprint(topic);
+    writeSerializedData(serializedDevice);
+    const uint32_t& configHash = mqtt()->endFingerprint();
+
+    if (configHash == getConfigHash()) {
+        return; // the same config was published already
+    }
+
     if (mqtt()->beginPublish(topic, dataLength, true)) {
         writeSerializedData(serializedDevice);
-        mqtt()->endPublish();
+
+        if (mqtt()->endPublish()) {
+            setConfigHash(configHash);
+        }
     }
 }
 
@@ -191,7 +223,7 @@ void HASwitch::subscribeCommandTopic()
         return;
     }
 
-    mqtt()->subscribe(topic);
+    mqtt()->subscribe(topic, this);
 }
 
 uint16_t HASwitch::calculateSerializedLength(const char* serializedDevice) const
@@ -211,13 +243,7 @@ uint16_t HASwitch::calculateSerializedLength(const char* serializedDevice) const
     size += DeviceTypeSerializer::calculateUniqueIdFieldSize(device, name());
     size += DeviceTypeSerializer::calculateDeviceFieldSize(serializedDevice);
 
-    if (isAvailabilityConfigured()) {
-        size += DeviceTypeSerializer::calculateAvailabilityFieldSize(
-            mqtt(),
-            componentName(),
-            name()
-        );
-    }
+    size += calculateAvailabilityFieldSize();
 
     // cmd topic
     {
@@ -327,13 +353,7 @@ bool HASwitch::writeSerializedData(const char* serializedDevice) const
     DeviceTypeSerializer::mqttWriteNameField(mqtt(), name());
     DeviceTypeSerializer::mqttWriteUniqueIdField(mqtt(), name());
 
-    if (isAvailabilityConfigured()) {
-        DeviceTypeSerializer::mqttWriteAvailabilityField(
-            mqtt(),
-            componentName(),
-            name()
-        );
-    }
+    mqttWriteAvailabilityField();
 
     DeviceTypeSerializer::mqttWriteDeviceField(mqtt(), serializedDevice);
     DeviceTypeSerializer::mqttWriteEndJson(mqtt());
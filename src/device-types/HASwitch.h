@@ -21,6 +21,11 @@ public:
         HAMqtt& mqtt
     );
 
+    /**
+     * Subscribes command topic of the switch.
+     */
+    virtual void onMqttSubscribe() override;
+
     /**
      * Publishes configuration of the sensor to the MQTT.
      */
@@ -36,6 +41,11 @@ public:
         const uint16_t& length
     ) override;
 
+    /**
+     * Publishes the latest state of the switch (see HAMqtt::setDeferredPublishing).
+     */
+    virtual bool onMqttFlush() override;
+
     /**
      * Returns name of the switch assigned via constructor.
      */
@@ -46,9 +56,10 @@ public:
      * Changes state of the switch and publishes MQTT message.
      * Please note that if a new value is the same as previous one,
      * the MQTT message won't be published.
+     * With deferred publishing the message is published by HAMqtt::flush.
      *
      * @param state New state of the switch.
-     * @returns Returns true if MQTT message has been published successfully.
+     * @returns Returns true if MQTT message has been published or queued successfully.
      */
     bool setState(bool state);
 
@@ -93,9 +93,20 @@ void HATagScanner::publishConfig()
         return;
     }
 
+    mqtt()->beginFingerprint(topic);
+    writeSerializedData(serializedDevice);
+    const uint32_t& configHash = mqtt()->endFingerprint();
+
+    if (configHash == getConfigHash()) {
+        return; // the same config was published already
+    }
+
     if (mqtt()->beginPublish(topic, dataLength, true)) {
         writeSerializedData(serializedDevice);
-        mqtt()->endPublish();
+
+        if (mqtt()->endPublish()) {
+            setConfigHash(configHash);
+        }
     }
 }
 
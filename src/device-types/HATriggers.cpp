@@ -5,16 +5,28 @@
 
 HATriggers::HATriggers(HAMqtt& mqtt) :
     BaseDeviceType(mqtt, "device_automation", nullptr),
+    _staticStorage(false),
     _triggers(nullptr),
-    _triggersNb(0)
+    _triggersNb(0),
+    _triggersCapacity(0)
+{
+
+}
+
+HATriggers::HATriggers(HAMqtt& mqtt, HATrigger* triggers, uint8_t maxTriggers) :
+    BaseDeviceType(mqtt, "device_automation", nullptr),
+    _staticStorage(true),
+    _triggers(triggers),
+    _triggersNb(0),
+    _triggersCapacity(maxTriggers)
 {
 
 }
 
 HATriggers::~HATriggers()
 {
-    if (_triggers != nullptr) {
-        free(_triggers);
+    if (_triggers != nullptr && !_staticStorage) {
+        ARDUINOHA_FREE(_triggers);
     }
 }
 
@@ -29,9 +41,18 @@ bool HATriggers::add(const char* type, const char* subtype)
         return false;
     }
 
-    HATrigger* triggers = (HATrigger*)realloc(_triggers, sizeof(HATrigger) * (_triggersNb + 1));
-    if (triggers == nullptr) {
-        return false;
+    if (_triggersNb == _triggersCapacity) {
+        if (_staticStorage) {
+            return false;
+        }
+
+        HATrigger* triggers = (HATrigger*)ARDUINOHA_REALLOC(_triggers, sizeof(HATrigger) * (_triggersCapacity + 1));
+        if (triggers == nullptr) {
+            return false;
+        }
+
+        _triggers = triggers;
+        _triggersCapacity++;
     }
 
 #if defined(ARDUINOHA_DEBUG)
@@ -42,7 +63,6 @@ bool HATriggers::add(const char* type, const char* subtype)
     Serial.println();
 #endif
 
-    _triggers = triggers;
     _triggers[_triggersNb].type = type;
     _triggers[_triggersNb].subtype = subtype;
 
@@ -107,6 +127,24 @@ void HATriggers::publishConfig()
         return;
     }
 
+    // single fingerprint covers configs of all triggers
+    mqtt()->beginFingerprint(nullptr);
+    publishTriggersConfigs(serializedDevice);
+    const uint32_t& configHash = mqtt()->endFingerprint();
+
+    if (configHash == getConfigHash()) {
+        return; // the same configs were published already
+    }
+
+    if (publishTriggersConfigs(serializedDevice)) {
+        setConfigHash(configHash);
+    }
+}
+
+bool HATriggers::publishTriggersConfigs(const char* serializedDevice)
+{
+    bool result = true;
+
     for (uint8_t i = 0; i < _triggersNb; i++) {
         const HATrigger* trigger = &_triggers[i];
         if (trigger == nullptr) {
@@ -141,9 +179,13 @@ void HATriggers::publishConfig()
 
         if (mqtt()->beginPublish(topic, dataLength, true)) {
             writeSerializedTrigger(trigger, serializedDevice);
-            mqtt()->endPublish();
+            result &= mqtt()->endPublish();
+        } else {
+            result = false;
         }
     }
+
+    return result;
 }
 
 uint16_t HATriggers::calculateTopicLength(
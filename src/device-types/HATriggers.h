@@ -25,6 +25,13 @@ public:
     bool trigger(const char* type, const char* subtype);
 
 protected:
+    /**
+     * Initializes triggers with the storage provided by the caller.
+     * The storage is never reallocated, so the number of triggers is limited
+     * to the given capacity. See HATriggersStatic for the heap-free variant of the class.
+     */
+    HATriggers(HAMqtt& mqtt, HATrigger* triggers, uint8_t maxTriggers);
+
     uint16_t calculateTopicLength(
         const char* component,
         const HATrigger *trigger,
@@ -42,6 +49,14 @@ protected:
 private:
     void publishConfig();
 
+    /**
+     * Publishes configs of all triggers.
+     * Returns true if all of them have been published successfully.
+     *
+     * @param serializedDevice
+     */
+    bool publishTriggersConfigs(const char* serializedDevice);
+
     uint16_t calculateSerializedLength(
         const HATrigger* trigger,
         const char* serializedDevice
@@ -52,8 +67,29 @@ private:
         const char* serializedDevice
     ) const;
 
+    const bool _staticStorage;
     HATrigger* _triggers;
     uint8_t _triggersNb;
+    uint8_t _triggersCapacity;
+};
+
+/**
+ * Variant of the HATriggers class that uses embedded storage instead of the heap.
+ *
+ * @tparam MaxTriggers Maximum number of triggers that can be added.
+ */
+template <uint8_t MaxTriggers>
+class HATriggersStatic : public HATriggers
+{
+public:
+    HATriggersStatic(HAMqtt& mqtt) :
+        HATriggers(mqtt, _triggersStorage, MaxTriggers)
+    {
+
+    }
+
+private:
+    HATrigger _triggersStorage[MaxTriggers];
 };
 
 #endif